@@ -137,7 +137,8 @@ function(visitlab_generate_lecture course lecture)
             OUTPUT "$<TARGET_FILE_DIR:${executable_target}>/configuration.toml"
             CONTENT "
 framework_dir = \"${CMAKE_SOURCE_DIR}/framework/\" 
-lecture_dir = \"${CMAKE_CURRENT_SOURCE_DIR}\"")
+lecture_dir = \"${CMAKE_CURRENT_SOURCE_DIR}\"
+cache_dir = \"$<TARGET_FILE_DIR:${executable_target}>/cache\"")
     endif()
 endfunction()
 
@@ -5,50 +5,16 @@
 
 #include <GLFW/glfw3.h>
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstddef>
 #include <glm/gtx/rotate_vector.hpp>
 #include <glm/gtx/transform.hpp>
 #include <imgui.h>
+#include <map>
 #include <memory>
 #include <stdexcept>
-
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-
-GLuint load_texture_2d(const std::filesystem::path filename) {
-    int width, height, channels;
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char* data = stbi_load(filename.generic_string().data(), &width, &height, &channels, 4);
-
-    GLuint texture;
-    glCreateTextures(GL_TEXTURE_2D, 1, &texture);
-
-    glTextureStorage2D(texture, std::log2(std::min(width, height)), GL_RGBA8, width, height);
-
-    glTextureSubImage2D(texture,
-                        0,                         //
-                        0, 0,                      //
-                        width, height,             //
-                        GL_RGBA, GL_UNSIGNED_BYTE, //
-                        data);
-
-    stbi_image_free(data);
-
-    glGenerateTextureMipmap(texture);
-
-    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    return texture;
-}
-
-Application::object::~object()
-{
-    glDeleteBuffers(1, &buffer);
-
-    if (has_texture)
-        glDeleteTextures(1, &texture);
-}
+#include <tuple>
 
 void Application::mko(
     Application::object& obj, const std::string& name,
@@ -58,31 +24,36 @@ void Application::mko(
     obj.has_texture = has_texture;
     obj.ignore_light = ignore_light;
 
-    if (has_texture)
+    // The assets are loaded in the background, the object is drawn using placeholders until they are uploaded
+    obj.texture = has_texture
+        ? texture_cache.get(images_path / ( name + ".jpg"))
+        : nullptr;
+
+    obj.model = model_ptr;
+    if (!model_ptr)
     {
-        obj.texture = load_texture_2d(images_path / ( name + ".jpg"));
+        asset_loader.load_geometry(objects_path / ( name + ".obj"),
+            [&obj](std::shared_ptr<Geometry> model) { obj.model = std::move(model); });
     }
 
-    obj.model = model_ptr
-        ? model_ptr
-        : std::make_shared<Geometry>(Geometry::from_file(objects_path / ( name + ".obj")));
-
-    obj.ubo.model_matrix = model_matrix;
-    obj.ubo.ambient_color = glm::vec4(0.5f);
-    obj.ubo.diffuse_color = glm::vec4(1.0f);
-    obj.ubo.specular_color = glm::vec4(0.0f);
+    obj.data.model_matrix = model_matrix;
+    obj.data.ambient_color = glm::vec4(0.5f);
+    obj.data.diffuse_color = glm::vec4(1.0f);
+    obj.data.specular_color = glm::vec4(0.0f);
 
-    obj.load_buffer();
+    obj.index = GLuint(objects.size());
+    obj.dirty = true;
+    objects.push_back(&obj);
 }
 
-void Application::object::load_buffer()
+void Application::rmo(Application::object& obj)
 {
-    glCreateBuffers(1, &buffer);
-    glNamedBufferStorage(
-        buffer,
-        sizeof(ObjectUBO),
-        &ubo,
-        0);
+    // The last record takes the place of the removed one
+    object* last = objects.back();
+    objects[obj.index] = last;
+    last->index = obj.index;
+    last->dirty = true;
+    objects.pop_back();
 }
 
 void Application::mkf(Application::frame_buffer& f)
@@ -100,6 +71,7 @@ void Application::print_hello()
               << "          D - decrease speed\r\n"
               << "          Q - show menu in space\r\n"
               << "          E - switch dimension\r\n"
+              << "          P - show profiler\r\n"
               << "          Hold right button to look around\r\n\n"
               << "Checklist:\r\n"
               << " - 4 unique complex objects (nature, room, chicken, airplane)\r\n"
@@ -133,6 +105,8 @@ Application::Application(int initial_width, int initial_height, std::vector<std:
             glm::vec3(ubo->position),
             glm::vec3(0.0f, 0.0f, -1.0f),
             glm::vec3(0.0f, 1.0f, 0.0f));
+        ubo->inverse_projection = glm::inverse(ubo->projection);
+        ubo->inverse_view = glm::inverse(ubo->view);
     }
 
     light_ubo.position = glm::vec4(10.0f, 10.0f, -10.0f, 0.0f);
@@ -153,23 +127,26 @@ Application::Application(int initial_width, int initial_height, std::vector<std:
     // --------------------------------------------------------------------------
     //  Load/Create Objects
     // --------------------------------------------------------------------------
+    const unsigned char white[4] = {255, 255, 255, 255};
+    glCreateTextures(GL_TEXTURE_2D, 1, &placeholder_texture);
+    glTextureStorage2D(placeholder_texture, 1, GL_RGBA8, 1, 1);
+    glTextureSubImage2D(placeholder_texture, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, white);
+
     mko(sphere, "", glm::mat4(1.0f), std::make_shared<Geometry>(Sphere()), false, true);
 
     auto earth_model_matrix = glm::translate(glm::vec3(0.0f, 0.0f, 1.0f));
     mko(earth, "earth", earth_model_matrix, sphere.model, true, false);
-    earth.ubo.ambient_color = glm::vec4(0.0f);
-    earth.ubo.diffuse_color = glm::vec4(0.3f);
-    earth.ubo.specular_color = glm::vec4(0.0f);
-    earth.load_buffer();
+    earth.data.ambient_color = glm::vec4(0.0f);
+    earth.data.diffuse_color = glm::vec4(0.3f);
+    earth.data.specular_color = glm::vec4(0.0f);
 
     auto sun_model_matrix = glm::translate(
         glm::scale(glm::vec3{5.0f, 5.0f, 5.0f}),
         glm::vec3(light_ubo.position));
     mko(sun_space, "sun", sun_model_matrix, sphere.model, true, false);
-    sun_space.ubo.ambient_color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-    sun_space.ubo.diffuse_color = glm::vec4(0.0f);
-    sun_space.ubo.specular_color = glm::vec4(0.0f);
-    sun_space.load_buffer();
+    sun_space.data.ambient_color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+    sun_space.data.diffuse_color = glm::vec4(0.0f);
+    sun_space.data.specular_color = glm::vec4(0.0f);
 
     mko(rocket, "rocket", glm::mat4(1.0f));
 
@@ -179,6 +156,7 @@ Application::Application(int initial_width, int initial_height, std::vector<std:
     mko(airplane, "airplane", glm::translate(glm::scale(glm::vec3(10.0f)),
                                              glm::vec3(0.0f, 2.0f, 0.0f)));
 
+    chickens.resize(7);
     mko(chickens[ 0 ], "chicken", glm::translate(glm::vec3(2.f, -3.3f, 1.f)));
 
     for (auto [ i, x, y ] : std::vector<std::tuple<int, double, double>>{
@@ -192,15 +170,13 @@ Application::Application(int initial_width, int initial_height, std::vector<std:
     {
         mko(
             chickens[ i ], "chicken",
-            glm::translate(glm::vec3(-0.f + x, -3.3f, -3.f + y)),
-            chickens[0].model);
+            glm::translate(glm::vec3(-0.f + x, -3.3f, -3.f + y)));
     }
 
     mko(sun_room, "", glm::translate(glm::scale(glm::vec3(2.0f)),
                                      glm::vec3(light_ubo.position)),
         std::make_shared<Geometry>(Sphere()), false, true);;
-    sun_room.ubo.ambient_color = glm::vec4(0.9f, 0.7f, 0.3f, 1.0f);
-    sun_room.load_buffer();
+    sun_room.data.ambient_color = glm::vec4(0.9f, 0.7f, 0.3f, 1.0f);
 
     std::vector<float> positions = {
         -12.6958f,      -0.1198f,       19.8613f,
@@ -223,8 +199,7 @@ Application::Application(int initial_width, int initial_height, std::vector<std:
 
     mko(screen, "sun", glm::mat4(1.0f), std::make_shared<Geometry>(
         Geometry(GL_TRIANGLES, positions, indices, {}, {}, texture_coords)), true, true);
-    screen.ubo.ambient_color = glm::vec4(1.0f);
-    screen.load_buffer();
+    screen.data.ambient_color = glm::vec4(1.0f);
 
     // --------------------------------------------------------------------------
     // Create Buffers
@@ -244,46 +219,65 @@ Application::Application(int initial_width, int initial_height, std::vector<std:
 
     mkf(space_bf);
     mkf(screen_bf);
+    for (auto& history : history_bf)
+        mkf(history);
+    history_size = glm::ivec2(width, height);
+
+    glCreateBuffers(GLsizei(marched_counters.size()), marched_counters.data());
+    for (GLuint counter : marched_counters)
+        glNamedBufferStorage(counter, 4 * sizeof(GLuint), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    // Every variant the passes may draw with is submitted next to the programs, so none is compiled during a frame
+    for (size_t i = 0; i < normal_variants.size(); i++) {
+        std::vector<std::string> defines = {"LIGHTS=" + std::to_string(1 + (i >> 2))};
+        if (i & 1)
+            defines.push_back("TEXTURED");
+        if (i & 2)
+            defines.push_back("UNLIT");
+        normal_variants[i] = &normal_programs.get(defines);
+    }
 
-    compile_shaders();
+    // The programs were submitted together by their initializers, the first frame needs them linked
+    for (ShaderProgram* program : programs) {
+        program->wait();
+        shader_watcher.watch(*program);
+    }
+    for (ShaderProgram* variant : normal_variants)
+        variant->wait();
+    shader_watcher.watch(normal_programs);
 }
 
 Application::~Application() {
-    delete_shaders();
-
     glDeleteBuffers(1, &light_buffer);
     glDeleteBuffers(1, &camera_space_buffer);
     glDeleteBuffers(1, &camera_room_buffer);
     glDeleteBuffers(1, &light_buffer);
     glDeleteBuffers(1, &light_room_buffer);
+    glDeleteTextures(1, &placeholder_texture);
+    glDeleteBuffers(GLsizei(marched_counters.size()), marched_counters.data());
+    glDeleteBuffers(1, &object_buffer);
+    glDeleteBuffers(1, &instance_buffer);
 }
 
 // ----------------------------------------------------------------------------
 // Methods
 // ----------------------------------------------------------------------------
 
-void Application::delete_shaders() {
-    glDeleteProgram(normal_program);
-    glDeleteProgram(postprocess_program);
-    glDeleteProgram(screen_program);
-}
-
 void Application::compile_shaders() {
-    delete_shaders();
-    normal_program = create_program(
-        lecture_shaders_path / "normal.vert",
-        lecture_shaders_path / "normal.frag");
-
-    postprocess_program = create_program(
-        lecture_shaders_path / "postprocess.vert",
-        lecture_shaders_path / "postprocess.frag");
-
-    screen_program = create_program(
-        lecture_shaders_path / "postprocess.vert",
-        lecture_shaders_path / "screen.frag");
+    // R only submits the programs, update swaps in each of them once it links and the old one is used until then
+    for (ShaderProgram* program : programs)
+        program->reload();
+    normal_programs.reload();
 }
 
 void Application::update(float delta) {
+    PV112Application::update(delta);
+
+    shader_watcher.update();
+    for (ShaderProgram* program : programs)
+        program->poll();
+    normal_programs.poll();
+
     auto& cam = is_space_scene ? camera_space_ubo : camera_room_ubo;
     auto& cam_front = is_space_scene ? cam_space_front : cam_room_front;
 
@@ -292,11 +286,13 @@ void Application::update(float delta) {
     if (s_hold)
         cam.position -= glm::vec4(cam_front, 0.0f) * speed * delta;
 
-    earth.ubo.model_matrix = glm::rotate(
-        earth.ubo.model_matrix,
+    earth.data.model_matrix = glm::rotate(
+        earth.data.model_matrix,
         glm::radians(delta * 0.02f),
         glm::vec3(0.0f, 1.0f, 0.0f));
-    earth.load_buffer();
+    earth.dirty = true;
+
+    update_chickens();
 }
 
 void Application::frame_buffer::bind()
@@ -308,6 +304,10 @@ void Application::frame_buffer::bind()
 void Application::render() {
     const float* clear_color = black_color;
 
+    asset_loader.upload();
+    uniform_ring.begin_frame();
+    upload_objects();
+
     // --------------------------------------------------------------------------
     // Update UBOs
     // --------------------------------------------------------------------------
@@ -319,6 +319,8 @@ void Application::render() {
         glm::vec3(camera_ubo.position),
         glm::vec3(camera_ubo.position) + cam_front,
         glm::vec3(0.0f, 1.0f, 0.0f));
+    camera_ubo.inverse_projection = glm::inverse(camera_ubo.projection);
+    camera_ubo.inverse_view = glm::inverse(camera_ubo.view);
 
     glNamedBufferSubData(camera_buffer, 0, sizeof(CameraUBO), &camera_ubo);
 
@@ -350,30 +352,154 @@ void Application::render() {
     glDisable(GL_CULL_FACE);
     glDisable(GL_DEPTH_TEST);
 
-    glUseProgram(postprocess_program);
-
     glBindBufferBase(GL_UNIFORM_BUFFER, 0, camera_space_buffer);
     glBindBufferBase(GL_UNIFORM_BUFFER, 1, light_buffer);
-    glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(camera_space_ubo.projection));
-    glUniformMatrix4fv(2, 1, GL_FALSE, glm::value_ptr(camera_space_ubo.view));
 
-    glUniform1i(3, number_of_measurements);
-    glUniform1i(4, number_of_optical_depths);
-    glUniform1f(5, density_falloff);
-    glUniform3fv(6, 1, glm::value_ptr(wave_lengths));
-    glUniform1f(7, scattering_strength);
+    // The sun ray transmittance is recomputed only when the atmosphere menu changes it
+    const bool parameters_changed =
+        transmittance_lut.update({density_falloff, scattering_strength, wave_lengths, number_of_optical_depths});
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, space_bf.texture);
+    glBindTextureUnit(1, transmittance_lut.get_texture());
+
+    // The counters written three frames ago are finished by now
+    const size_t counter = atmosphere_frame % marched_counters.size();
+    if (marched_totals[counter] > 0) {
+        GLuint counts[4] = {};
+        glGetNamedBufferSubData(marched_counters[counter], 0, sizeof(counts), counts);
+        marched_fraction = float(counts[0]) / float(marched_totals[counter]);
+        std::copy(counts + 1, counts + 4, tile_counts.begin());
+    }
+    const GLuint zeros[4] = {};
+    glNamedBufferSubData(marched_counters[counter], 0, sizeof(zeros), zeros);
+    glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 0, marched_counters[counter]);
+
+    ProfileScope postprocess_scope("postprocess");
 
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    postprocess_program.use();
+    set_atmosphere_uniforms(postprocess_program);
+
+    if (atmosphere_resolution == 0 && !temporal_atmosphere && !compute_atmosphere) {
+        postprocess_program.set(8, 0);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        marched_totals[counter] = GLuint64(width) * GLuint64(height);
+    } else {
+        const int atmosphere_width = std::max(1, width >> atmosphere_resolution);
+        const int atmosphere_height = std::max(1, height >> atmosphere_resolution);
+        if (atmosphere_bf.width != atmosphere_width || atmosphere_bf.height != atmosphere_height)
+            atmosphere_bf.load_buffer(atmosphere_width, atmosphere_height);
+
+        // The reduced-resolution passes write without the blending, it would scale the scattering by its transmittance
+        glDisable(GL_BLEND);
+
+        if (compute_atmosphere) {
+            // The tiles missing the atmosphere are not dispatched, they keep the values of no scattering
+            const float no_scattering[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            const float no_depth = -1.0f;
+            glClearTexImage(atmosphere_bf.scattering, 0, GL_RGBA, GL_FLOAT, no_scattering);
+            glClearTexImage(atmosphere_bf.depth, 0, GL_RED, GL_FLOAT, &no_depth);
+
+            const glm::uvec4 empty_dispatches[3] = { {0, 1, 1, 0}, {0, 1, 1, 0}, {0, 1, 1, 0} };
+            glNamedBufferSubData(atmosphere_bf.tiles, 0, sizeof(empty_dispatches), empty_dispatches);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, atmosphere_bf.tiles);
+
+            const GLuint tiles_x = GLuint(atmosphere_width + 7) / 8;
+            const GLuint tiles_y = GLuint(atmosphere_height + 7) / 8;
+
+            classify_program.use();
+            classify_program.set(13, glm::ivec2(atmosphere_width, atmosphere_height));
+            glDispatchCompute((tiles_x + 7) / 8, (tiles_y + 7) / 8, 1);
+            glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+            // Keeps the tile counts of every class next to the raymarched pixel counter
+            for (GLintptr tile_class = 0; tile_class < 3; tile_class++)
+                glCopyNamedBufferSubData(atmosphere_bf.tiles, marched_counters[counter],
+                                         tile_class * sizeof(glm::uvec4), (tile_class + 1) * sizeof(GLuint),
+                                         sizeof(GLuint));
+
+            atmosphere_program.use();
+            set_atmosphere_uniforms(atmosphere_program);
+            atmosphere_program.set(13, glm::ivec2(atmosphere_width, atmosphere_height));
+            glBindImageTexture(0, atmosphere_bf.scattering, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+            glBindImageTexture(1, atmosphere_bf.depth, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+            glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, atmosphere_bf.tiles);
+            for (GLuint tile_class = 1; tile_class < 3; tile_class++) {
+                atmosphere_program.set(14, tile_class);
+                glDispatchComputeIndirect(GLintptr(tile_class * sizeof(glm::uvec4)));
+            }
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+            postprocess_program.use();
+        } else {
+            // Raymarches at the reduced resolution
+            glBindFramebuffer(GL_FRAMEBUFFER, atmosphere_bf.name);
+            glViewport(0, 0, atmosphere_width, atmosphere_height);
+
+            postprocess_program.set(8, 1);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+        }
+        marched_totals[counter] = GLuint64(atmosphere_width) * GLuint64(atmosphere_height);
+
+        glBindTextureUnit(2, atmosphere_bf.scattering);
+        glBindTextureUnit(3, atmosphere_bf.depth);
+
+        if (temporal_atmosphere) {
+            if (history_size != glm::ivec2(atmosphere_width, atmosphere_height)) {
+                for (auto& history : history_bf)
+                    history.load_buffer(atmosphere_width, atmosphere_height);
+                history_size = glm::ivec2(atmosphere_width, atmosphere_height);
+                history_valid = false;
+            }
+
+            // The history is dropped when the camera jumps or the atmosphere changes, the clamping would only hide it
+            const glm::vec3 camera_position = glm::vec3(camera_space_ubo.position);
+            if (parameters_changed || number_of_measurements != history_measurements
+                || glm::distance(camera_position, previous_camera_position) > 0.1f
+                || glm::dot(cam_space_front, previous_camera_front) < std::cos(glm::radians(10.0f)))
+                history_valid = false;
+
+            // Blends the raymarched scattering into the other history buffer
+            glBindFramebuffer(GL_FRAMEBUFFER, history_bf[1 - history_index].name);
+            glViewport(0, 0, atmosphere_width, atmosphere_height);
+
+            postprocess_program.set(8, 3);
+            postprocess_program.set(12, history_valid);
+            postprocess_program.set(9, previous_view_projection);
+            glBindTextureUnit(4, history_bf[history_index].texture);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+
+            history_index = 1 - history_index;
+            history_valid = true;
+            history_measurements = number_of_measurements;
+            glBindTextureUnit(2, history_bf[history_index].texture);
+        } else {
+            history_valid = false;
+        }
+
+        // Upsamples and composites at the full resolution
+        glEnable(GL_BLEND);
+        glBindFramebuffer(GL_FRAMEBUFFER, screen_bf.name);
+        glViewport(0, 0, (GLsizei)width, (GLsizei)height);
+
+        postprocess_program.set(8, 2);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+    }
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    postprocess_scope.end();
+
+    atmosphere_frame++;
+    previous_view_projection = camera_space_ubo.projection * camera_space_ubo.view;
+    previous_camera_position = glm::vec3(camera_space_ubo.position);
+    previous_camera_front = cam_space_front;
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
     if (is_space_scene) {
         glClear(GL_COLOR_BUFFER_BIT);
 
-        glUseProgram(screen_program);
+        screen_program.use();
 
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, screen_bf.texture);
@@ -392,16 +518,109 @@ void Application::render() {
 
         render_scene();
     }
+
+    uniform_ring.end_frame();
+}
+
+void Application::set_atmosphere_uniforms(ShaderProgram& program)
+{
+    program.set(3, number_of_measurements);
+    program.set(5, density_falloff);
+    program.set(6, wave_lengths);
+    program.set(7, scattering_strength);
+
+    program.set(11, temporal_atmosphere);
+    program.set(10, std::fmod(float(atmosphere_frame) * 0.618034f, 1.0f));
+}
+
+void Application::upload_objects()
+{
+    // The buffers grow by doubling, the new ones are created with all records as nothing reads them yet
+    if (object_capacity < objects.size()) {
+        object_capacity = std::max<size_t>(2 * object_capacity, objects.size());
+
+        std::vector<ObjectData> records(object_capacity);
+        for (object* o : objects) {
+            records[o->index] = o->data;
+            o->dirty = false;
+        }
+        glDeleteBuffers(1, &object_buffer);
+        glCreateBuffers(1, &object_buffer);
+        glNamedBufferStorage(object_buffer, GLsizeiptr(object_capacity * sizeof(ObjectData)), records.data(),
+                             GL_DYNAMIC_STORAGE_BIT);
+
+        // The identity is followed by the space for as many instanced indices
+        std::vector<GLuint> identity(object_capacity);
+        for (size_t i = 0; i < object_capacity; i++)
+            identity[i] = GLuint(i);
+        glDeleteBuffers(1, &instance_buffer);
+        glCreateBuffers(1, &instance_buffer);
+        glNamedBufferStorage(instance_buffer, GLsizeiptr(2 * object_capacity * sizeof(GLuint)), nullptr,
+                             GL_DYNAMIC_STORAGE_BIT);
+        glNamedBufferSubData(instance_buffer, 0, GLsizeiptr(object_capacity * sizeof(GLuint)), identity.data());
+    }
+
+    // The records leave the room for the instance indices and the draw commands of the scene pushed later
+    const GLsizeiptr scene_size = GLsizeiptr(objects.size() * (sizeof(GLuint) + sizeof(DrawElementsIndirectCommand)));
+
+    for (object* o : objects) {
+        if (!o->dirty)
+            continue;
+
+        // The records that do not fit into the ring (e.g., many added objects) are uploaded by the driver
+        if (uniform_ring.fits(sizeof(ObjectData) + scene_size, 16)) {
+            const GLintptr offset = uniform_ring.push(&o->data, sizeof(ObjectData), 16);
+            glCopyNamedBufferSubData(uniform_ring.get_buffer(), object_buffer, offset,
+                                     GLintptr(o->index * sizeof(ObjectData)), sizeof(ObjectData));
+        } else {
+            glNamedBufferSubData(object_buffer, GLintptr(o->index * sizeof(ObjectData)), sizeof(ObjectData), &o->data);
+        }
+        o->dirty = false;
+    }
+}
+
+void Application::update_chickens()
+{
+    // The added chickens share the model of the first one, so they wait until it is loaded
+    const object& first = chickens.front();
+    if (!first.model)
+        return;
+
+    while (chickens.size() > size_t(chicken_count)) {
+        rmo(chickens.back());
+        chickens.pop_back();
+    }
+
+    // The grid is sized for the slider maximum, so a chicken keeps its cell when the count changes, and it starts in
+    // front of the 7 chickens placed by hand
+    const int side = int(std::ceil(std::sqrt(double(MAX_CHICKENS - 7))));
+    while (chickens.size() < size_t(chicken_count)) {
+        const int i = int(chickens.size()) - 7;
+        object& chicken = chickens.emplace_back();
+        chicken.model = first.model;
+        chicken.texture = first.texture;
+        chicken.has_texture = first.has_texture;
+        chicken.ignore_light = first.ignore_light;
+        chicken.data = first.data;
+        chicken.data.model_matrix = glm::translate(
+            glm::vec3(1.5f * float(i % side - side / 2), -3.3f, 3.0f + 1.5f * float(i / side)));
+
+        chicken.index = GLuint(objects.size());
+        objects.push_back(&chicken);
+    }
 }
 
 void Application::render_universe()
 {
-    glUseProgram(normal_program);
+    PROFILE_SCOPE("render_universe");
+
+    normal_lights = 1;
 
     glBindBufferBase(GL_UNIFORM_BUFFER, 0, camera_space_buffer);
     glBindBufferBase(GL_UNIFORM_BUFFER, 1, light_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, object_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, instance_buffer);
 
-    glUniform1i(glGetUniformLocation(normal_program, "light_count"), 1);
 
     dro(sun_space);
     dro(earth);
@@ -410,51 +629,218 @@ void Application::render_universe()
 
 void Application::render_scene()
 {
-    glUseProgram(normal_program);
+    PROFILE_SCOPE("render_scene");
+
+    normal_lights = 2;
 
     glBindBufferBase(GL_UNIFORM_BUFFER, 0, camera_room_buffer);
     glBindBufferBase(GL_UNIFORM_BUFFER, 1, light_room_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, object_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, instance_buffer);
 
-    glUniform1i(glGetUniformLocation(normal_program, "light_count"), 2);
 
-    dro(room);
-    dro(nature);
-    dro(airplane);
-    dro(sun_room);
+    const auto start = std::chrono::steady_clock::now();
 
+    // The screen shows the rendered space instead of its own texture
+    std::vector<std::pair<object*, GLuint>> scene = {
+        {&room, 0}, {&nature, 0}, {&airplane, 0}, {&sun_room, 0}, {&screen, screen_bf.texture}};
     for (auto& o : chickens)
-    {
-        dro(o);
+        scene.emplace_back(&o, 0);
+
+    scene_objects = int(scene.size());
+    scene_draw_calls = 0;
+    scene_groups = 0;
+
+    if (!batched_scene) {
+        for (auto [o, texture] : scene)
+            dro(*o, texture);
+        scene_draw_calls = scene_objects;
+    } else {
+        // The objects sharing a permutation, a geometry and a texture are merged into one instanced draw, the
+        // permutation bits are TEXTURED and UNLIT
+        struct group {
+            int permutation;
+            std::shared_ptr<Geometry> geometry;
+            GLuint texture;
+            std::vector<GLuint> indices;
+        };
+        std::vector<group> groups;
+        std::map<std::tuple<int, const Geometry*, GLuint>, size_t> group_of;
+
+        size_t current = 0;
+        for (auto [o, texture] : scene) {
+            const std::shared_ptr<Geometry>& geometry = o->model ? o->model : sphere.model;
+            if (!o->has_texture)
+                texture = 0;
+            else if (!texture)
+                texture = o->texture && o->texture->name ? o->texture->name : placeholder_texture;
+            const int permutation = int(o->has_texture) | int(o->ignore_light) << 1;
+
+            // Repeated objects usually follow each other, so the map is searched only when the group changes
+            if (groups.empty() || groups[current].permutation != permutation || groups[current].geometry != geometry
+                || groups[current].texture != texture) {
+                const auto [found, inserted] =
+                    group_of.try_emplace({permutation, geometry.get(), texture}, groups.size());
+                if (inserted)
+                    groups.push_back({permutation, geometry, texture, {}});
+                current = found->second;
+            }
+            groups[current].indices.push_back(o->index);
+        }
+        scene_groups = int(groups.size());
+
+        // The indices of the groups are copied after the identity part of the instance buffer
+        std::vector<GLuint> instances;
+        instances.reserve(scene.size());
+        std::vector<GLuint> base_instances;
+        base_instances.reserve(groups.size());
+        for (const group& g : groups) {
+            base_instances.push_back(GLuint(object_capacity + instances.size()));
+            instances.insert(instances.end(), g.indices.begin(), g.indices.end());
+        }
+        const GLintptr instances_offset =
+            uniform_ring.push(instances.data(), GLsizeiptr(instances.size() * sizeof(GLuint)), 4);
+        glCopyNamedBufferSubData(uniform_ring.get_buffer(), instance_buffer, instances_offset,
+                                 GLintptr(object_capacity * sizeof(GLuint)),
+                                 GLsizeiptr(instances.size() * sizeof(GLuint)));
+
+        struct draw {
+            int permutation;
+            int pool;
+            GLuint texture;
+            DrawElementsIndirectCommand command;
+        };
+        std::vector<draw> draws;
+        draws.reserve(groups.size());
+
+        for (size_t i = 0; i < groups.size(); i++) {
+            const group& g = groups[i];
+            const GLuint count = GLuint(g.indices.size());
+
+            const MeshArena::Mesh* mesh = mesh_arena.add(g.geometry);
+            if (!mesh) {
+                normal_variant(g.permutation & 1, g.permutation & 2).use();
+                if (g.texture)
+                    glBindTextureUnit(3, g.texture);
+                g.geometry->draw_instanced(int(count), base_instances[i]);
+                scene_draw_calls++;
+                continue;
+            }
+
+            draws.push_back({g.permutation, mesh->pool, g.texture,
+                             {mesh->count, count, mesh->first_index, mesh->base_vertex, base_instances[i]}});
+        }
+
+        // The draws are sorted by the permutation first, so that every variant is bound once, the draws sharing
+        // a pool and a texture are then consecutive commands of one multi-draw
+        std::sort(draws.begin(), draws.end(), [](const draw& a, const draw& b) {
+            return std::tie(a.permutation, a.pool, a.texture) < std::tie(b.permutation, b.pool, b.texture);
+        });
+
+        std::vector<DrawElementsIndirectCommand> commands;
+        commands.reserve(draws.size());
+        for (const draw& d : draws)
+            commands.push_back(d.command);
+
+        const GLintptr commands_offset = commands.empty()
+            ? 0
+            : uniform_ring.push(commands.data(), GLsizeiptr(commands.size() * sizeof(DrawElementsIndirectCommand)), 4);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, uniform_ring.get_buffer());
+
+        for (size_t first = 0; first < draws.size();) {
+            size_t last = first + 1;
+            while (last < draws.size() && draws[last].permutation == draws[first].permutation
+                   && draws[last].pool == draws[first].pool && draws[last].texture == draws[first].texture)
+                last++;
+
+            if (first == 0 || draws[first].permutation != draws[first - 1].permutation)
+                normal_variant(draws[first].permutation & 1, draws[first].permutation & 2).use();
+
+            const int pool = draws[first].pool;
+            mesh_arena.bind(pool);
+            if (draws[first].texture)
+                glBindTextureUnit(3, draws[first].texture);
+
+            const GLintptr offset = commands_offset + GLintptr(first * sizeof(DrawElementsIndirectCommand));
+            glMultiDrawElementsIndirect(mesh_arena.get_mode(pool), mesh_arena.get_index_type(pool),
+                                        reinterpret_cast<const void*>(offset), GLsizei(last - first), 0);
+            scene_draw_calls++;
+            first = last;
+        }
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glBindVertexArray(0);
     }
 
-    // A bit nasty trick so i don't have to make interface more complicated (destructors)
-    std::swap(screen.texture, screen_bf.texture);
-    dro(screen);
-    std::swap(screen.texture, screen_bf.texture);
+    scene_submit_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
-void Application::dro(Application::object& o)
+void Application::dro(Application::object& o, GLuint texture)
 {
-    glUniform1i(glGetUniformLocation(normal_program, "has_texture"), o.has_texture);
-    glUniform1i(glGetUniformLocation(normal_program, "ignore_light"), o.ignore_light);
+    normal_variant(o.has_texture, o.ignore_light).use();
+
+    if (!texture)
+        texture = o.texture && o.texture->name ? o.texture->name : placeholder_texture;
 
     if (o.has_texture)
-        glBindTextureUnit(3, o.texture);
+        glBindTextureUnit(3, texture);
 
-    glBindBufferRange(GL_UNIFORM_BUFFER, 2, o.buffer, 0, sizeof(ObjectUBO));
+    // Objects whose model is still loading are drawn as spheres, the identity part of the instance buffer maps
+    // the base instance to the record of the object
+    (o.model ? o.model : sphere.model)->draw_instanced(1, o.index);
+}
 
-    o.model->draw();
+namespace {
+// Registers the C++ structures of the blocks during the static initialization, i.e., before any program links
+struct BlockLayoutsRegistration {
+    BlockLayoutsRegistration()
+    {
+        ShaderProgram::add_block_layout({"Camera", "", sizeof(CameraUBO), {
+            {"projection", offsetof(CameraUBO, projection)},
+            {"view", offsetof(CameraUBO, view)},
+            {"position", offsetof(CameraUBO, position)},
+            {"inverse_projection", offsetof(CameraUBO, inverse_projection)},
+            {"inverse_view", offsetof(CameraUBO, inverse_view)},
+        }});
+        ShaderProgram::add_block_layout({"Lights", "lights", sizeof(LightUBO), {
+            {"position", offsetof(LightUBO, position)},
+            {"ambient_color", offsetof(LightUBO, ambient_color)},
+            {"diffuse_color", offsetof(LightUBO, diffuse_color)},
+            {"specular_color", offsetof(LightUBO, specular_color)},
+        }});
+        ShaderProgram::add_block_layout({"Objects", "objects", sizeof(ObjectData), {
+            {"model_matrix", offsetof(ObjectData, model_matrix)},
+            {"ambient_color", offsetof(ObjectData, ambient_color)},
+            {"diffuse_color", offsetof(ObjectData, diffuse_color)},
+            {"specular_color", offsetof(ObjectData, specular_color)},
+        }});
+    }
+} block_layouts_registration;
+} // namespace
+
+ShaderProgram& Application::normal_variant(bool textured, bool unlit)
+{
+    // The pointers stay valid, the variants are only recompiled in place by compile_shaders
+    return *normal_variants[int(textured) | int(unlit) << 1 | (normal_lights - 1) << 2];
 }
 
 void Application::render_ui() {
+    if (show_profiler && Profiler::get_active())
+        profiler_panel.render(*Profiler::get_active(), fps_cpu);
+
     if (!is_space_scene) {
         const float unit = ImGui::GetFontSize();
 
         ImGui::Begin("Parameters", nullptr, ImGuiWindowFlags_NoDecoration);
-        ImGui::SetWindowSize(ImVec2(14 * unit, 2 * unit));
+        ImGui::SetWindowSize(ImVec2(24 * unit, 7 * unit));
         ImGui::SetWindowPos(ImVec2(1 * unit, 1 * unit));
 
         ImGui::Text("Press E to change dimension");
+        ImGui::Checkbox("Batched draws", &batched_scene);
+        ImGui::SliderInt("Chickens", &chicken_count, 7, MAX_CHICKENS, "%d",
+                         ImGuiSliderFlags_Logarithmic | ImGuiSliderFlags_AlwaysClamp);
+        ImGui::Text("Draws: %d for %d objects in %d groups", scene_draw_calls, scene_objects, scene_groups);
+        ImGui::Text("Submit: %.3f ms", scene_submit_time);
 
         ImGui::End();
 
@@ -465,7 +851,7 @@ void Application::render_ui() {
 
     if (show_menu) {
         ImGui::Begin("Parameters", nullptr, ImGuiWindowFlags_NoDecoration);
-        ImGui::SetWindowSize(ImVec2(32 * unit, 9 * unit));
+        ImGui::SetWindowSize(ImVec2(32 * unit, 15 * unit));
         ImGui::SetWindowPos(ImVec2(1 * unit, 1 * unit));
 
         ImGui::SliderInt("Measurements", &number_of_measurements, 1, 20);
@@ -474,6 +860,20 @@ void Application::render_ui() {
         ImGui::SliderFloat("Scattering strength", &scattering_strength, 0.0f, 40.0f);
         ImGui::SliderFloat3("Wavelengths", glm::value_ptr(wave_lengths), 0.0f, 1000.0f);
 
+        const char* resolutions[] = { "Full", "Half", "Quarter" };
+        ImGui::Combo("Resolution", &atmosphere_resolution, resolutions, IM_ARRAYSIZE(resolutions));
+        ImGui::Checkbox("Temporal accumulation", &temporal_atmosphere);
+        ImGui::Checkbox("Compute tiles", &compute_atmosphere);
+        const Profiler* profiler = Profiler::get_active();
+        ImGui::Text("Atmosphere: %.1f%% of pixels raymarched, %.2f ms on GPU", 100.0f * marched_fraction,
+                    profiler ? profiler->get_gpu_time("postprocess") : 0.0);
+        if (compute_atmosphere)
+            ImGui::Text("Tiles: %u empty, %u atmosphere, %u planet", tile_counts[0], tile_counts[1], tile_counts[2]);
+
+        ImGui::Text("Textures: %zu resident, %.1f MiB, %zu hits, %zu misses",
+                    texture_cache.resident_count, texture_cache.resident_bytes / (1024.0 * 1024.0),
+                    texture_cache.hits, texture_cache.misses);
+
         ImGui::End();
     } else {
         ImGui::Begin("Parameters", nullptr, ImGuiWindowFlags_NoDecoration);
@@ -497,6 +897,7 @@ Application::frame_buffer::~frame_buffer()
 
 void Application::frame_buffer::load_buffer(int w, int h)
 {
+    glDeleteTextures(1, &texture);
     glCreateTextures(GL_TEXTURE_2D, 1, &texture);
     glTextureStorage2D(texture, 1, GL_RGBA32F, w, h);
 
@@ -506,6 +907,44 @@ void Application::frame_buffer::load_buffer(int w, int h)
     glNamedFramebufferTexture(name, GL_COLOR_ATTACHMENT0, texture, 0);
 }
 
+Application::atmosphere_buffer::~atmosphere_buffer()
+{
+    glDeleteTextures(1, &scattering);
+    glDeleteTextures(1, &depth);
+    glDeleteBuffers(1, &tiles);
+    glDeleteFramebuffers(1, &name);
+}
+
+void Application::atmosphere_buffer::load_buffer(int w, int h)
+{
+    glDeleteTextures(1, &scattering);
+    glDeleteTextures(1, &depth);
+    if (!name)
+        glCreateFramebuffers(1, &name);
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &scattering);
+    glTextureStorage2D(scattering, 1, GL_RGBA16F, w, h);
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &depth);
+    glTextureStorage2D(depth, 1, GL_R32F, w, h);
+
+    const GLenum draw_buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glNamedFramebufferDrawBuffers(name, 2, draw_buffers);
+
+    glNamedFramebufferTexture(name, GL_COLOR_ATTACHMENT0, scattering, 0);
+    glNamedFramebufferTexture(name, GL_COLOR_ATTACHMENT1, depth, 0);
+
+    // The dispatches of the three classes followed by two lists long enough for all tiles
+    const GLsizeiptr tile_count = GLsizeiptr((w + 7) / 8) * ((h + 7) / 8);
+    glDeleteBuffers(1, &tiles);
+    glCreateBuffers(1, &tiles);
+    glNamedBufferStorage(tiles, 3 * sizeof(glm::uvec4) + 2 * tile_count * sizeof(GLuint), nullptr,
+                         GL_DYNAMIC_STORAGE_BIT);
+
+    width = w;
+    height = h;
+}
+
 void Application::on_resize(int width, int height) {
     space_bf.load_buffer(width, height);
     screen_bf.load_buffer(width, height);
@@ -578,5 +1017,8 @@ void Application::on_key_pressed(int key, int scancode, int action, int mods) {
     if (key == GLFW_KEY_E && action == GLFW_PRESS)
         is_space_scene = !is_space_scene;
 
+    if (key == GLFW_KEY_P && action == GLFW_PRESS)
+        show_profiler = !show_profiler;
+
     PV112Application::on_key_pressed(key, scancode, action, mods);
 }
@@ -7,21 +7,37 @@
 
 #pragma once
 
+#include "asset_loader.hpp"
 #include "camera.h"
 #include "cube.hpp"
 #include "geometry.hpp"
+#include "mesh_arena.hpp"
+#include "profiler_panel.h"
 #include "pv112_application.hpp"
+#include "shader_permutations.hpp"
+#include "shader_program.hpp"
+#include "shader_watcher.hpp"
 #include "sphere.hpp"
 #include "teapot.hpp"
+#include "texture_cache.hpp"
+#include "transmittance_lut.hpp"
+#include "uniform_ring.hpp"
+#include <deque>
 #include <memory>
 
 // ----------------------------------------------------------------------------
 // UNIFORM STRUCTS
 // ----------------------------------------------------------------------------
+// The blocks are declared once in shaders/include, the programs are checked against these structures when they
+// link, see BlockLayoutsRegistration in application.cpp
 struct CameraUBO {
     glm::mat4 projection;
     glm::mat4 view;
     glm::vec4 position;
+
+    // The screen-space passes reconstruct the view rays from these instead of inverting the matrices per pixel
+    glm::mat4 inverse_projection;
+    glm::mat4 inverse_view;
 };
 
 struct LightUBO {
@@ -31,7 +47,8 @@ struct LightUBO {
     glm::vec4 specular_color;
 };
 
-struct alignas(256) ObjectUBO {
+// An element of the std430 Objects buffer of shaders/include/objects.glsl, the records are tightly packed
+struct ObjectData {
     glm::mat4 model_matrix;  // [  0 -  64) bytes
     glm::vec4 ambient_color; // [ 64 -  80) bytes
     glm::vec4 diffuse_color; // [ 80 -  96) bytes
@@ -39,6 +56,7 @@ struct alignas(256) ObjectUBO {
     // Contains shininess in .w element
     glm::vec4 specular_color; // [ 96 - 112) bytes
 };
+static_assert(sizeof(ObjectData) == 112, "ObjectData must match the std430 layout of the Objects buffer");
 
 // Constants
 const float blue_color[4] = {0.3, 0.3, 0.9, 1.0};
@@ -48,25 +66,39 @@ const float clear_depth[1] = {1.0};
 class Application : public PV112Application {
     struct object {
         std::shared_ptr<Geometry> model;
-        GLuint buffer;
-        ObjectUBO ubo;
-        GLuint texture; // Might be shared for some project, not needed here
+        ObjectData data;
+        std::shared_ptr<Texture> texture;
         bool has_texture;
         bool ignore_light;
 
-        ~object();
-        void load_buffer();
+        // The index of the record in the object buffer, drawn as the base instance
+        GLuint index = 0;
+        // Set when the data changes, the record is uploaded before the next frame
+        bool dirty = true;
     };
 
     struct frame_buffer {
-        GLuint name;
-        GLuint texture;
+        GLuint name = 0;
+        GLuint texture = 0;
 
         ~frame_buffer();
         void load_buffer(int, int);
         void bind();
     };
 
+    struct atmosphere_buffer {
+        GLuint name = 0;
+        GLuint scattering = 0;
+        GLuint depth = 0;
+        // The tiles sorted by atmosphere_classify.comp, see its Tiles block
+        GLuint tiles = 0;
+        int width = 0;
+        int height = 0;
+
+        ~atmosphere_buffer();
+        void load_buffer(int, int);
+    };
+
     // ----------------------------------------------------------------------------
     // Variables
     // ----------------------------------------------------------------------------
@@ -74,6 +106,38 @@ class Application : public PV112Application {
     std::filesystem::path images_path = lecture_folder_path / "images";
     std::filesystem::path objects_path = lecture_folder_path / "objects";
 
+    // Assets
+    AssetLoader asset_loader;
+    TextureCache texture_cache{asset_loader};
+    GLuint placeholder_texture = 0;
+
+    // The records of all objects indexed by object::index, the dirty ones are staged through the uniform ring
+    std::vector<object*> objects;
+    GLuint object_buffer = 0;
+    size_t object_capacity = 0;
+
+    // The indices of the records read by normal.vert at the base instance plus the instance ID. The first
+    // object_capacity indices are the identity used by single draws, the instanced groups of the frame follow.
+    GLuint instance_buffer = 0;
+
+    // A frame stages the instance indices and the draw commands of the largest scene the chickens slider allows, the
+    // records of at most RING_RECORDS dirty objects fit besides, the others are uploaded by the driver
+    static const int MAX_CHICKENS = 100000;
+    static const size_t MAX_SCENE_OBJECTS = MAX_CHICKENS + 5;
+    static const size_t RING_RECORDS = 4096;
+    UniformRing uniform_ring{UniformRing::blocks_size(RING_RECORDS, sizeof(ObjectData), 16)
+                             + UniformRing::blocks_size(MAX_SCENE_OBJECTS, sizeof(GLuint), 4)
+                             + UniformRing::blocks_size(MAX_SCENE_OBJECTS, sizeof(DrawElementsIndirectCommand), 4)};
+
+    // The room scene is drawn by a glMultiDrawElementsIndirect per pool and texture, the commands are written
+    // into the uniform ring
+    MeshArena mesh_arena;
+    bool batched_scene = true;
+    int scene_draw_calls = 0;
+    int scene_objects = 0;
+    int scene_groups = 0;
+    double scene_submit_time = 0.0;
+
     // Camera
     CameraUBO camera_room_ubo;
     GLuint camera_room_buffer = 0;
@@ -101,9 +165,18 @@ class Application : public PV112Application {
     frame_buffer screen_bf;
 
     // Programs
-    GLuint normal_program;
-    GLuint postprocess_program;
-    GLuint screen_program;
+    // The objects are drawn by the TEXTURED, UNLIT and LIGHTS permutations of normal.frag, see normal_variant
+    ShaderPermutations normal_programs{lecture_shaders_path / "normal.vert", lecture_shaders_path / "normal.frag"};
+    std::array<ShaderProgram*, 8> normal_variants{};
+    int normal_lights = 1;
+    ShaderProgram postprocess_program{lecture_shaders_path / "postprocess.vert", lecture_shaders_path / "postprocess.frag"};
+    ShaderProgram screen_program{lecture_shaders_path / "postprocess.vert", lecture_shaders_path / "screen.frag"};
+    ShaderProgram classify_program{lecture_shaders_path / "atmosphere_classify.comp"};
+    ShaderProgram atmosphere_program{lecture_shaders_path / "atmosphere.comp"};
+    // The programs above are compiled together in the background, see compile_shaders
+    std::array<ShaderProgram*, 4> programs{&postprocess_program, &screen_program, &classify_program, &atmosphere_program};
+    // Reloads only the programs depending on the edited shader files
+    ShaderWatcher shader_watcher{lecture_shaders_path};
 
     // Helper objects
     object sphere;
@@ -117,6 +190,10 @@ class Application : public PV112Application {
     object sun_space;
     object rocket;
 
+    // The profiler window toggled by P
+    bool show_profiler = false;
+    ProfilerPanel profiler_panel;
+
     // Atmosphere parameters
     bool show_menu = false;
     int number_of_measurements = 10;
@@ -124,6 +201,33 @@ class Application : public PV112Application {
     float density_falloff = 4.3f;
     glm::vec3 wave_lengths = glm::vec3(700, 530, 440);
     float scattering_strength = 8.0f;
+    TransmittanceLut transmittance_lut;
+
+    // The scattering is raymarched at 1 / 2^atmosphere_resolution of the window size
+    int atmosphere_resolution = 0;
+    atmosphere_buffer atmosphere_bf;
+
+    // The compute variant raymarches only the 8x8 tiles classified as reaching into the atmosphere
+    bool compute_atmosphere = false;
+
+    // The counters of the raymarched pixels followed by the counts of the tiles missing the atmosphere, inside
+    // the atmosphere only and hitting the planet, read back a few frames later so the reading does not stall
+    std::array<GLuint, 3> marched_counters{};
+    std::array<GLuint64, 3> marched_totals{};
+    float marched_fraction = 0.0f;
+    std::array<GLuint, 3> tile_counts{};
+
+    // The temporal accumulation jitters the measurements every frame and blends them into the history
+    bool temporal_atmosphere = false;
+    size_t atmosphere_frame = 0;
+    std::array<frame_buffer, 2> history_bf;
+    size_t history_index = 0;
+    glm::ivec2 history_size{0};
+    bool history_valid = false;
+    int history_measurements = 0;
+    glm::mat4 previous_view_projection{1.0f};
+    glm::vec3 previous_camera_position{0.0f};
+    glm::vec3 previous_camera_front{0.0f};
 
     // Room scene
     LightUBO light_room_ubo[2];
@@ -131,17 +235,27 @@ class Application : public PV112Application {
 
     object room;
     object nature;
-    std::array<object, 7> chickens;
+    // The first 7 chickens are placed by hand, the others fill a grid when the count is raised in the menu
+    std::deque<object> chickens;
+    int chicken_count = 7;
     object airplane;
     object sun_room;
     object screen;
 
     void mko(object& obj, const std::string&, glm::mat4,
         std::shared_ptr<Geometry> = nullptr, bool = true, bool = false);
-    void dro(object& obj);
+    void rmo(object& obj);
+    void dro(object& obj, GLuint = 0);
+
+    // Returns the variant of normal.frag for the lights of the current pass
+    ShaderProgram& normal_variant(bool textured, bool unlit);
 
     void mkf(frame_buffer&);
 
+    void set_atmosphere_uniforms(ShaderProgram& program);
+    void upload_objects();
+    void update_chickens();
+
     bool is_space_scene = true;
 
     // Renders
@@ -173,9 +287,6 @@ class Application : public PV112Application {
     /** @copydoc PV112Application::compile_shaders */
     void compile_shaders() override;
 
-    /** @copydoc PV112Application::delete_shaders */
-    void delete_shaders() override;
-
     /** @copydoc PV112Application::update */
     void update(float delta) override;
 
@@ -0,0 +1,171 @@
+#include "asset_loader.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+// ----------------------------------------------------------------------------
+// Constructors & Destructors
+// ----------------------------------------------------------------------------
+
+AssetLoader::AssetLoader(unsigned int threads_count, size_t upload_budget)
+    : upload_budget(upload_budget) {
+    if (threads_count == 0) {
+        threads_count = std::max(1u, std::thread::hardware_concurrency() - 1);
+    }
+
+    // The flag is global in stb_image, it is set before any worker starts decoding.
+    stbi_set_flip_vertically_on_load(true);
+
+    for (unsigned int i = 0; i < threads_count; i++) {
+        workers.emplace_back(&AssetLoader::run_worker, this);
+    }
+}
+
+AssetLoader::~AssetLoader() {
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex);
+        stopping = true;
+        jobs.clear();
+    }
+    jobs_condition.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Methods
+// ----------------------------------------------------------------------------
+
+size_t AssetLoader::Payload::size() const {
+    if (is_texture) {
+        if (const MipChain* chain = std::get_if<MipChain>(&image)) {
+            return chain->pixels.size();
+        }
+        return std::get<CompressedImage>(image).blocks.size();
+    }
+    return mesh.size();
+}
+
+void AssetLoader::load_geometry(const std::filesystem::path& path, GeometryCallback on_ready) {
+    // Requests of a file that is already being loaded just wait for the same geometry.
+    auto [it, inserted] = pending_geometries.try_emplace(path.generic_string());
+    it->second.push_back(std::move(on_ready));
+    if (!inserted) {
+        return;
+    }
+
+    enqueue([this, path]() {
+        Payload payload;
+        payload.path = path;
+        // The workers already load the assets in parallel, so every model is parsed on its worker only.
+        payload.mesh = Model::load_mesh(path, 1);
+        finished.push(std::move(payload));
+    });
+}
+
+void AssetLoader::load_texture(const std::filesystem::path& path, bool compress, TextureCallback on_ready) {
+    enqueue([this, path, compress, on_ready = std::move(on_ready)]() {
+        Payload payload;
+        payload.path = path;
+        payload.is_texture = true;
+        payload.on_texture = on_ready;
+
+        // The cached blocks need neither decoding nor compression.
+        if (compress) {
+            if (std::optional<CompressedImage> cached = CompressedImage::load(path)) {
+                payload.image = std::move(*cached);
+                finished.push(std::move(payload));
+                return;
+            }
+        }
+
+        int width, height, channels;
+        unsigned char* pixels = stbi_load(path.generic_string().data(), &width, &height, &channels, 4);
+        if (!pixels) {
+            finished.push(std::move(payload));
+            return;
+        }
+
+        // The mipmaps are built here rather than by the driver on the OpenGL thread.
+        MipChain image = build_mip_chain(width, height, pixels);
+        stbi_image_free(pixels);
+
+        if (compress) {
+            CompressedImage compressed = compress_image(image);
+            compressed.store(path);
+            payload.image = std::move(compressed);
+        } else {
+            payload.image = std::move(image);
+        }
+        finished.push(std::move(payload));
+    });
+}
+
+void AssetLoader::upload() {
+    size_t uploaded = 0;
+    while (uploaded < upload_budget || uploaded == 0) {
+        std::optional<Payload> payload = finished.pop();
+        if (!payload) {
+            break;
+        }
+        uploaded += payload->size();
+        pending--;
+
+        if (payload->is_texture) {
+            if (std::visit([](const auto& image) { return image.levels.empty(); }, payload->image)) {
+                std::cerr << "Could not load texture " << payload->path.generic_string() << std::endl;
+                continue;
+            }
+            payload->on_texture(payload->image);
+        } else {
+            const auto node = pending_geometries.extract(payload->path.generic_string());
+            if (payload->mesh.empty()) {
+                std::cerr << "Could not load geometry " << payload->path.generic_string() << std::endl;
+                continue;
+            }
+
+            const std::shared_ptr<Geometry> geometry = std::make_shared<Geometry>(payload->mesh.create_geometry());
+            for (const GeometryCallback& on_ready : node.mapped()) {
+                on_ready(geometry);
+            }
+        }
+
+        if (pending == 0) {
+            const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - batch_start;
+            std::cout << "AssetLoader: all assets uploaded in " << duration.count() << " ms" << std::endl;
+        }
+    }
+}
+
+void AssetLoader::enqueue(std::function<void()> job) {
+    if (pending++ == 0) {
+        batch_start = std::chrono::steady_clock::now();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex);
+        jobs.push_back(std::move(job));
+    }
+    jobs_condition.notify_one();
+}
+
+void AssetLoader::run_worker() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(jobs_mutex);
+            jobs_condition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (stopping) {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
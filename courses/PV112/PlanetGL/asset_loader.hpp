@@ -0,0 +1,144 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include "block_compression.hpp"
+#include "geometry.hpp"
+#include "mip_chain.hpp"
+#include "model.hpp"
+#include "mpsc_queue.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+/**
+ * Loads models and textures in the background.
+ * <p>
+ * The worker threads read the files, parse the models, decode the images and build their mipmap chains (and compress
+ * them if requested). The finished CPU data are handed over to
+ * the OpenGL thread through a lock-free queue and {@link upload} creates the OpenGL objects, at most
+ * {@link upload_budget} bytes per call (but always at least one asset so that large assets are not starved). The
+ * callbacks are invoked from {@link upload}, i.e., on the OpenGL thread.
+ */
+class AssetLoader {
+public:
+    using GeometryCallback = std::function<void(std::shared_ptr<Geometry>)>;
+    /** The loaded image with all its mipmap levels, either as RGBA8 pixels or as compressed blocks. */
+    using TextureImage = std::variant<MipChain, CompressedImage>;
+
+    using TextureCallback = std::function<void(const TextureImage& image)>;
+
+private:
+    /** The CPU data of a loaded asset waiting for the upload. */
+    struct Payload {
+        std::filesystem::path path;
+        bool is_texture = false;
+
+        /** The loaded model (only for geometries), a cached model stays mapped until it is uploaded. */
+        LoadedMesh mesh;
+
+        /** The loaded image with all its mipmap levels (only for textures), without any level if the loading failed. */
+        TextureImage image;
+
+        TextureCallback on_texture;
+
+        /** Returns the number of bytes uploaded to the GPU. */
+        size_t size() const;
+    };
+
+    // ----------------------------------------------------------------------------
+    // Variables
+    // ----------------------------------------------------------------------------
+public:
+    /** The maximum number of bytes uploaded by a single call of {@link upload}. */
+    size_t upload_budget;
+
+private:
+    std::vector<std::thread> workers;
+
+    /** The jobs waiting for a worker. */
+    std::deque<std::function<void()>> jobs;
+    std::mutex jobs_mutex;
+    std::condition_variable jobs_condition;
+    bool stopping = false;
+
+    /** The loaded assets waiting for the upload. */
+    MpscQueue<Payload> finished;
+
+    /** The callbacks of the geometries being loaded, the same file is loaded only once. */
+    std::unordered_map<std::string, std::vector<GeometryCallback>> pending_geometries;
+
+    /** The number of requested assets that were not uploaded yet. */
+    size_t pending = 0;
+
+    /** The time when the first asset of the current batch was requested. */
+    std::chrono::steady_clock::time_point batch_start;
+
+    // ----------------------------------------------------------------------------
+    // Constructors & Destructors
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Creates a new @link AssetLoader and starts its worker threads.
+     *
+     * @param 	threads_count	The number of worker threads (0 to use all hardware threads but one).
+     * @param 	upload_budget	The maximum number of bytes uploaded by a single call of {@link upload}.
+     */
+    explicit AssetLoader(unsigned int threads_count = 0, size_t upload_budget = 16 * 1024 * 1024);
+
+    /** Stops the workers, the assets that were not uploaded yet are dropped. */
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // ----------------------------------------------------------------------------
+    // Methods
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Requests a geometry to be loaded from the specified file. Requests of the same file share the loaded geometry.
+     *
+     * @param 	path    	The path to the model.
+     * @param 	on_ready	The callback receiving the uploaded geometry.
+     */
+    void load_geometry(const std::filesystem::path& path, GeometryCallback on_ready);
+
+    /**
+     * Requests a texture to be loaded from the specified file.
+     * <p>
+     * Compressed images are cached next to the source image (see {@link CompressedImage::store}), so the image is
+     * decoded and compressed only the first time.
+     *
+     * @param 	path    	The path to the image.
+     * @param 	compress	True to compress the image into BC1/BC3 blocks.
+     * @param 	on_ready	The callback receiving the image with all its mipmap levels, it is responsible for the upload.
+     */
+    void load_texture(const std::filesystem::path& path, bool compress, TextureCallback on_ready);
+
+    /** Uploads the loaded assets within the budget, must be called on the OpenGL thread (e.g., once per frame). */
+    void upload();
+
+    /** Returns the number of requested assets that were not uploaded yet. */
+    size_t pending_count() const { return pending; }
+
+private:
+    /** Adds a job for the workers. */
+    void enqueue(std::function<void()> job);
+
+    /** The main loop of the worker threads. */
+    void run_worker();
+};
@@ -0,0 +1,109 @@
+#include "mesh_arena.hpp"
+
+#include <algorithm>
+
+// ----------------------------------------------------------------------------
+// Constructors & Destructors
+// ----------------------------------------------------------------------------
+
+MeshArena::~MeshArena() {
+    for (Pool& pool : pools) {
+        glDeleteVertexArrays(1, &pool.vao);
+        glDeleteBuffers(1, &pool.vertex_buffer);
+        glDeleteBuffers(1, &pool.index_buffer);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Methods
+// ----------------------------------------------------------------------------
+
+bool MeshArena::Pool::matches(const Geometry& geometry) const {
+    return mode == geometry.mode && index_type == geometry.index_type && stride == geometry.vertex_buffer_stride
+           && position_loc == geometry.position_loc && normal_loc == geometry.normal_loc
+           && tex_coord_loc == geometry.tex_coord_loc && tangent_loc == geometry.tangent_loc
+           && bitangent_loc == geometry.bitangent_loc && color_loc == geometry.color_loc;
+}
+
+const MeshArena::Mesh* MeshArena::add(const std::shared_ptr<Geometry>& geometry) {
+    const auto found = meshes.find(geometry.get());
+    if (found != meshes.end())
+        return &found->second.second;
+
+    if (geometry->draw_elements_count == 0 || geometry->mode == GL_PATCHES || geometry->vertex_buffer_stride == 0)
+        return nullptr;
+
+    auto pool = std::find_if(pools.begin(), pools.end(), [&](const Pool& p) { return p.matches(*geometry); });
+    if (pool == pools.end()) {
+        Pool created;
+        created.mode = geometry->mode;
+        created.index_type = geometry->index_type;
+        created.stride = geometry->vertex_buffer_stride;
+        created.position_loc = geometry->position_loc;
+        created.normal_loc = geometry->normal_loc;
+        created.tex_coord_loc = geometry->tex_coord_loc;
+        created.tangent_loc = geometry->tangent_loc;
+        created.bitangent_loc = geometry->bitangent_loc;
+        created.color_loc = geometry->color_loc;
+
+        // The attributes are set up the same way as by the VAO of the geometry
+        glCreateVertexArrays(1, &created.vao);
+        for (GLint location : {created.position_loc, created.normal_loc, created.color_loc, created.tex_coord_loc,
+                               created.tangent_loc, created.bitangent_loc}) {
+            if (location < 0)
+                continue;
+
+            GLint size = 0;
+            GLint offset = 0;
+            glGetVertexArrayIndexediv(geometry->vao, location, GL_VERTEX_ATTRIB_ARRAY_SIZE, &size);
+            glGetVertexArrayIndexediv(geometry->vao, location, GL_VERTEX_ATTRIB_RELATIVE_OFFSET, &offset);
+            glEnableVertexArrayAttrib(created.vao, location);
+            glVertexArrayAttribFormat(created.vao, location, size, GL_FLOAT, GL_FALSE, offset);
+            glVertexArrayAttribBinding(created.vao, location, 0);
+        }
+
+        pools.push_back(created);
+        pool = pools.end() - 1;
+    }
+
+    const GLsizeiptr index_size = geometry->index_size();
+    const GLsizeiptr vertex_bytes = geometry->vertex_buffer_size;
+    const GLsizeiptr index_bytes = GLsizeiptr(geometry->draw_elements_count) * index_size;
+    if (pool->vertex_size + vertex_bytes > pool->vertex_capacity || pool->index_size + index_bytes > pool->index_capacity)
+        resize(*pool, std::max(2 * pool->vertex_capacity, pool->vertex_size + vertex_bytes),
+               std::max(2 * pool->index_capacity, pool->index_size + index_bytes));
+
+    glCopyNamedBufferSubData(geometry->vertex_buffer, pool->vertex_buffer, 0, pool->vertex_size, vertex_bytes);
+    glCopyNamedBufferSubData(geometry->index_buffer, pool->index_buffer, 0, pool->index_size, index_bytes);
+
+    const Mesh mesh{int(pool - pools.begin()), GLuint(geometry->draw_elements_count),
+                    GLuint(pool->index_size / index_size), GLint(pool->vertex_size / pool->stride)};
+    pool->vertex_size += vertex_bytes;
+    pool->index_size += index_bytes;
+
+    return &meshes.emplace(geometry.get(), std::make_pair(geometry, mesh)).first->second.second;
+}
+
+void MeshArena::bind(int pool) const { glBindVertexArray(pools[pool].vao); }
+
+void MeshArena::resize(Pool& pool, GLsizeiptr vertex_capacity, GLsizeiptr index_capacity) {
+    GLuint buffers[2];
+    glCreateBuffers(2, buffers);
+    glNamedBufferStorage(buffers[0], vertex_capacity, nullptr, 0);
+    glNamedBufferStorage(buffers[1], index_capacity, nullptr, 0);
+
+    if (pool.vertex_size > 0)
+        glCopyNamedBufferSubData(pool.vertex_buffer, buffers[0], 0, 0, pool.vertex_size);
+    if (pool.index_size > 0)
+        glCopyNamedBufferSubData(pool.index_buffer, buffers[1], 0, 0, pool.index_size);
+
+    glDeleteBuffers(1, &pool.vertex_buffer);
+    glDeleteBuffers(1, &pool.index_buffer);
+    pool.vertex_buffer = buffers[0];
+    pool.index_buffer = buffers[1];
+    pool.vertex_capacity = vertex_capacity;
+    pool.index_capacity = index_capacity;
+
+    glVertexArrayVertexBuffer(pool.vao, 0, pool.vertex_buffer, 0, pool.stride);
+    glVertexArrayElementBuffer(pool.vao, pool.index_buffer);
+}
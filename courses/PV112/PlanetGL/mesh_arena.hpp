@@ -0,0 +1,117 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include "geometry.hpp"
+#include "glad/glad.h"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/** The command read by glMultiDrawElementsIndirect, see the OpenGL specification. */
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instance_count;
+    GLuint first_index;
+    GLint base_vertex;
+    GLuint base_instance;
+};
+
+/**
+ * The indexed meshes copied into a few large vertex and index buffers, so that the meshes sharing a vertex format
+ * can be drawn by a single glMultiDrawElementsIndirect with one VAO.
+ * <p>
+ * The meshes are grouped into pools by their vertex format, primitive mode and index type. A mesh is copied on the GPU
+ * from the buffers of its {@link Geometry} the first time it is added, its place in the pool is then described by
+ * the first index and the base vertex of its draw commands. The buffers of a pool grow by doubling.
+ */
+class MeshArena {
+
+    // ----------------------------------------------------------------------------
+    // Nested Types
+    // ----------------------------------------------------------------------------
+public:
+    /** The place of a mesh in the arena. */
+    struct Mesh {
+        /** The index of the pool, see {@link bind}. */
+        int pool;
+        GLuint count;
+        GLuint first_index;
+        GLint base_vertex;
+    };
+
+private:
+    /** The meshes sharing a vertex format, primitive mode and index type. */
+    struct Pool {
+        // The key of the pool
+        GLenum mode;
+        GLenum index_type;
+        GLsizei stride;
+        GLint position_loc;
+        GLint normal_loc;
+        GLint tex_coord_loc;
+        GLint tangent_loc;
+        GLint bitangent_loc;
+        GLint color_loc;
+
+        GLuint vao = 0;
+        GLuint vertex_buffer = 0;
+        GLuint index_buffer = 0;
+        GLsizeiptr vertex_capacity = 0;
+        GLsizeiptr vertex_size = 0;
+        GLsizeiptr index_capacity = 0;
+        GLsizeiptr index_size = 0;
+
+        bool matches(const Geometry& geometry) const;
+    };
+
+    // ----------------------------------------------------------------------------
+    // Variables
+    // ----------------------------------------------------------------------------
+private:
+    std::vector<Pool> pools;
+
+    /** The added meshes, the geometries are kept alive so that their addresses are not reused. */
+    std::unordered_map<const Geometry*, std::pair<std::shared_ptr<Geometry>, Mesh>> meshes;
+
+    // ----------------------------------------------------------------------------
+    // Constructors & Destructors
+    // ----------------------------------------------------------------------------
+public:
+    MeshArena() = default;
+
+    MeshArena(const MeshArena&) = delete;
+    MeshArena& operator=(const MeshArena&) = delete;
+
+    ~MeshArena();
+
+    // ----------------------------------------------------------------------------
+    // Methods
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Returns the place of the geometry in the arena, copying it there the first time.
+     *
+     * @param 	geometry	The geometry to add.
+     * @return	The mesh, or null if the geometry cannot be drawn indirectly (it is not indexed or uses patches).
+     */
+    const Mesh* add(const std::shared_ptr<Geometry>& geometry);
+
+    /** Binds the VAO of the pool, its index buffer is the element buffer of the draw commands. */
+    void bind(int pool) const;
+
+    /** Returns the primitive mode of the meshes of the pool. */
+    GLenum get_mode(int pool) const { return pools[pool].mode; }
+
+    /** Returns the index type of the meshes of the pool. */
+    GLenum get_index_type(int pool) const { return pools[pool].index_type; }
+
+private:
+    /** Creates the buffers of a pool with the specified capacities, copying the contents of the old ones. */
+    void resize(Pool& pool, GLsizeiptr vertex_capacity, GLsizeiptr index_capacity);
+};
@@ -0,0 +1,44 @@
+// The geometry of the planet and its atmosphere
+
+#include "camera.glsl"
+
+const vec3 earth_position = vec3(0.0f, 0.0f, 1.0f);
+const float earth_radius = 1.0f;
+const float atmosphere_radius = 1.6;
+
+// Returns the view ray through a point of the screen, given in [0, 1]
+vec3 get_ray(vec2 uv) {
+    vec2 nds = (uv - vec2(0.5)) * 2;
+    vec4 ray_eye = camera.inverse_projection * vec4(nds, -1.0f, 1.0f);
+    return normalize((camera.inverse_view * vec4(ray_eye.xy, -1.0f, 0.0f)).xyz);
+}
+
+struct intersections {
+    float t1;
+    float t2;
+    bool did;
+};
+
+intersections get_sphere_intersection_t(
+    vec3 sphere_position, float sphere_radius,
+    vec3 position, vec3 direction_normal) {
+    float t = dot(sphere_position - position, direction_normal);
+
+    vec3 sphere_intersection_midpoint = position + direction_normal * t;
+    float distance_to_sphere_mid = length(sphere_intersection_midpoint - sphere_position);
+
+    if (distance_to_sphere_mid < sphere_radius) {
+        float half_intersect_length = sqrt(sphere_radius * sphere_radius
+            - distance_to_sphere_mid * distance_to_sphere_mid);
+        float t1 = t - half_intersect_length;
+        float t2 = t + half_intersect_length;
+
+        if (t1 < 0.0f && t2 < 0.0f) {
+            return intersections(0.0f, 0.0f, false);
+        }
+
+        return intersections(min(t1, t2), max(t1, t2), true);
+    }
+
+    return intersections(0.0f, 0.0f, false);
+}
@@ -0,0 +1,9 @@
+// The camera of the scene, mirrors CameraUBO
+layout(binding = 0, std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    vec3 position;
+    mat4 inverse_projection;
+    mat4 inverse_view;
+}
+camera;
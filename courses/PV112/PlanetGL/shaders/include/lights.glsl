@@ -0,0 +1,16 @@
+// The lights of the scene, each mirrors LightUBO. LIGHTS is the number of the lights in the bound buffer, the
+// programs may define it before including this file
+#ifndef LIGHTS
+#define LIGHTS 1
+#endif
+
+struct Light {
+    vec4 position;
+    vec4 ambient_color;
+    vec4 diffuse_color;
+    vec4 specular_color;
+};
+
+layout(binding = 1, std140) uniform Lights {
+    Light lights[LIGHTS];
+};
@@ -0,0 +1,12 @@
+// The records of all objects, each mirrors ObjectData
+struct Object {
+    mat4 model_matrix;
+    vec4 ambient_color;
+    vec4 diffuse_color;
+    // Contains shininess in .w element
+    vec4 specular_color;
+};
+
+layout(binding = 2, std430) readonly buffer Objects {
+    Object objects[];
+};
@@ -0,0 +1,78 @@
+// The raymarching of the light scattered in the atmosphere, shared by postprocess.frag and atmosphere.comp
+
+#include "atmosphere.glsl"
+#include "lights.glsl"
+
+// The transmittance along the sun rays indexed by the sun zenith cosine (x) and the scaled height (y), see TransmittanceLut
+layout(binding = 1) uniform sampler2D transmittance_lut;
+
+layout(location = 3) uniform int number_of_measurements;
+layout(location = 5) uniform float density_falloff;
+layout(location = 6) uniform vec3 wave_lengths;
+layout(location = 7) uniform float scattering_strength;
+
+// The temporal accumulation offsets the measurements by a different fraction of the step every frame
+layout(location = 10) uniform float jitter;
+layout(location = 11) uniform bool temporal;
+
+float density_at_point(vec3 position) {
+    float height_above_surface = length(position - earth_position) - earth_radius;
+    float height_scaled = height_above_surface / (atmosphere_radius - earth_radius);
+    float local_density = exp(-height_scaled * density_falloff) * (1 - height_scaled);
+
+    return local_density;
+}
+
+vec3 sun_transmittance(vec3 position, vec3 dir_to_sun) {
+    vec3 up = position - earth_position;
+    float radius = length(up);
+    float height_scaled = clamp((radius - earth_radius) / (atmosphere_radius - earth_radius), 0.0f, 1.0f);
+    float sun_cos = dot(up / radius, dir_to_sun);
+
+    // The texels store the values at their centers, the first and the last one at the ends of the range.
+    vec2 lut_size = vec2(textureSize(transmittance_lut, 0));
+    vec2 uv = vec2(sun_cos * 0.5f + 0.5f, height_scaled);
+    return textureLod(transmittance_lut, (uv * (lut_size - 1.0f) + 0.5f) / lut_size, 0.0f).rgb;
+}
+
+// Returns a per-pixel value in [0, 1) that decorrelates the jitter of the neighboring pixels
+float interleaved_gradient_noise(vec2 pixel_center) {
+    return fract(52.9829189f * fract(dot(pixel_center, vec2(0.06711056f, 0.00583715f))));
+}
+
+// Returns the scattered light and the transmittance of the original color in alpha
+vec4 calculate_light(vec3 position, vec3 direction_normal, float length, vec2 pixel_center) {
+    vec3 scatter_color = pow(400 / wave_lengths, vec3(4)) * scattering_strength;
+
+    // The temporal measurements cover the ray in equal strata, each starting at a jittered offset,
+    // otherwise the first and the last measurement lie at the ends of the ray
+    float step_size = temporal
+        ? length / number_of_measurements
+        : length / (number_of_measurements - 1);
+    float offset = temporal ? fract(interleaved_gradient_noise(pixel_center) + jitter) : 0.0f;
+
+    vec3 scatter_point = position + direction_normal * step_size * offset;
+    vec3 scattered_light = vec3(0.0f);
+    vec3 dir_to_sun = normalize(lights[0].position.xyz - earth_position);
+    float view_ray_optical_depth = 0;
+    float previous_density = density_at_point(position);
+
+    for (int i = 0; i < number_of_measurements; i++) {
+        float local_density = density_at_point(scatter_point);
+
+        // The view ray depth grows by the segment from the previous measurement (trapezoidal rule),
+        // the sun ray depth is looked up.
+        float segment = i == 0 ? offset * step_size : step_size;
+        view_ray_optical_depth += (previous_density + local_density) * 0.5f * segment;
+        previous_density = local_density;
+
+        vec3 transmittance = sun_transmittance(scatter_point, dir_to_sun)
+            * exp(-view_ray_optical_depth * scatter_color);
+
+        scattered_light += local_density * transmittance * scatter_color * step_size;
+        scatter_point += direction_normal * step_size;
+    }
+    float original_color_transmittance = exp(-view_ray_optical_depth);
+
+    return vec4(scattered_light, original_color_transmittance);
+}
@@ -1,75 +1,54 @@
 #version 450
 
-layout(binding = 0, std140) uniform Camera {
-    mat4 projection;
-    mat4 view;
-    vec3 position;
-}
-camera;
-
-struct Light {
-    vec4 position;
-    vec4 ambient_color;
-    vec4 diffuse_color;
-    vec4 specular_color;
-};
-
-layout(binding = 1, std140) uniform LightBuffer {
-    Light lights[2];
-}
-lightBuffer;
-
-layout(binding = 2, std140) uniform Object {
-    mat4 model_matrix;
+// The permutations are compiled with these defines:
+//   TEXTURED - the albedo is read from albedo_texture
+//   UNLIT    - only the ambient color is used, no lights are evaluated
+//   LIGHTS   - the number of lights in Lights, the loop over them has a constant bound
 
-    vec4 ambient_color;
-    vec4 diffuse_color;
-    vec4 specular_color;
-}
-object;
-
-layout(location = 3) uniform bool has_texture = false;
-layout(location = 4) uniform bool ignore_light = false;
-layout(location = 5) uniform int light_count = 0;
+#include "include/camera.glsl"
+#include "include/lights.glsl"
+#include "include/objects.glsl"
 
+#ifdef TEXTURED
 layout(binding = 3) uniform sampler2D albedo_texture;
+#endif
 
 layout(location = 0) in vec3 fs_position;
 layout(location = 1) in vec3 fs_normal;
 layout(location = 2) in vec2 fs_texture_coordinate;
+layout(location = 3) flat in uint fs_object;
 
 layout(location = 0) out vec4 final_color;
 
 void main() {
-    if (ignore_light) {
-        vec3 color = object.ambient_color.rgb
-            * (has_texture ? texture(albedo_texture, fs_texture_coordinate).rgb : vec3(1.0));
+    Object object = objects[fs_object];
 
-        final_color = vec4(color, 1.0f);
-
-        return;
-    }
+#ifdef TEXTURED
+    vec3 albedo = texture(albedo_texture, fs_texture_coordinate).rgb;
+#else
+    vec3 albedo = vec3(1.0);
+#endif
 
+#ifdef UNLIT
+    final_color = vec4(object.ambient_color.rgb * albedo, 1.0f);
+#else
     vec3 color = vec3(0.0f);
 
-    for (int i = 0; i < light_count; i++) {
-        Light light = lightBuffer.lights[i];
+    vec3 N = normalize(fs_normal);
+    vec3 E = normalize(camera.position - fs_position);
+
+    for (int i = 0; i < LIGHTS; i++) {
+        Light light = lights[i];
 
         vec3 light_vector = light.position.xyz - fs_position * light.position.w;
         vec3 L = normalize(light_vector);
-        vec3 N = normalize(fs_normal);
-        vec3 E = normalize(camera.position - fs_position);
         vec3 H = normalize(L + E);
 
         float NdotL = max(dot(N, L), 0.0);
         float NdotH = max(dot(N, H), 0.0001);
 
-        vec3 ambient = object.ambient_color.rgb
-            * (has_texture ? texture(albedo_texture, fs_texture_coordinate).rgb : vec3(1.0))
-            * light.ambient_color.rgb;
-        vec3 diffuse = object.diffuse_color.rgb
-            * (has_texture ? texture(albedo_texture, fs_texture_coordinate).rgb : vec3(1.0))
-            * light.diffuse_color.rgb;
+        vec3 ambient = object.ambient_color.rgb * albedo * light.ambient_color.rgb;
+        vec3 diffuse = object.diffuse_color.rgb * albedo * light.diffuse_color.rgb;
         vec3 specular = object.specular_color.rgb * light.specular_color.rgb;
 
         color += ambient.rgb
@@ -86,4 +65,5 @@ void main() {
     // color = pow(color, vec3(1.0 / 2.2)); // gamma correction
 
     final_color = vec4(color, 1.0);
+#endif
 }
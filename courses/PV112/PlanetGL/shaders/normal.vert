@@ -1,24 +1,13 @@
 #version 450
+#extension GL_ARB_shader_draw_parameters : require
 
-layout(binding = 0, std140) uniform Camera {
-	mat4 projection;
-	mat4 view;
-	vec3 position;
-} camera;
+#include "include/camera.glsl"
+#include "include/objects.glsl"
 
-layout(binding = 1, std140) uniform Light {
-	vec4 position;
-	vec4 ambient_color;
-	vec4 diffuse_color;
-	vec4 specular_color;
-} light;
-
-layout(binding = 2, std140) uniform Object {
-	mat4 model_matrix;
-	vec4 ambient_color;
-	vec4 diffuse_color;
-	vec4 specular_color;
-} object;
+// The indices of the records, an instance of a draw reads the one at its base instance plus its instance ID
+layout(binding = 3, std430) readonly buffer Instances {
+	uint instances[];
+};
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
@@ -27,9 +16,13 @@ layout(location = 2) in vec2 texture_coordinate;
 layout(location = 0) out vec3 fs_position;
 layout(location = 1) out vec3 fs_normal;
 layout(location = 2) out vec2 fs_texture_coordinate;
+layout(location = 3) flat out uint fs_object;
 
 void main()
 {
+	fs_object = instances[gl_BaseInstanceARB + gl_InstanceID];
+	Object object = objects[fs_object];
+
 	fs_position = vec3(object.model_matrix * vec4(position, 1.0));
 	fs_normal = transpose(inverse(mat3(object.model_matrix))) * normal;
 	fs_texture_coordinate = texture_coordinate;
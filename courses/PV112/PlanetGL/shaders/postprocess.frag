@@ -2,144 +2,110 @@
 
 // Inspired by https://www.youtube.com/watch?v=DxfEbulyFcY
 
-layout(binding = 0, std140) uniform Camera {
-    mat4 projection;
-    mat4 view;
-    vec3 position;
-}
-camera;
-
-layout(binding = 1, std140) uniform Light {
-    vec4 position;
-    vec4 ambient_color;
-    vec4 diffuse_color;
-    vec4 specular_color;
-}
-light;
+#include "include/scattering.glsl"
 
-layout(location = 1) uniform mat4 projection;
-layout(location = 2) uniform mat4 view;
 uniform sampler2D renderTexture;
 
-layout(location = 3) uniform int number_of_measurements;
-layout(location = 4) uniform int number_of_optical_depths;
-layout(location = 5) uniform float density_falloff;
-layout(location = 6) uniform vec3 wave_lengths;
-layout(location = 7) uniform float scattering_strength;
+// 0: raymarches and composites at full resolution,
+// 1: raymarches the scattering into the reduced-resolution buffers,
+// 2: upsamples the reduced-resolution buffers and composites them at full resolution,
+// 3: blends the reduced-resolution scattering into the history
+layout(location = 8) uniform int atmosphere_pass;
+
+// The reduced-resolution buffers, the scattered light with the view ray transmittance in alpha, and the depths
+layout(binding = 2) uniform sampler2D scattering_texture;
+layout(binding = 3) uniform sampler2D depth_texture;
 
-const vec3 earth_position = vec3(0.0f, 0.0f, 1.0f);
-const float earth_radius = 1.0f;
-const float atmosphere_radius = 1.6;
+// The temporal accumulation, the history of the previous frames is reprojected using the previous view and projection
+layout(location = 9) uniform mat4 previous_view_projection;
+layout(location = 12) uniform bool history_valid;
+layout(binding = 4) uniform sampler2D history_texture;
+
+// The weight of the current frame in the history
+const float temporal_blend = 0.1f;
+
+// The number of pixels that entered the raymarching loop
+layout(binding = 0, offset = 0) uniform atomic_uint marched_pixels;
 
 in vec2 UV;
+in vec3 view_ray;
 
-out vec4 color;
+layout(location = 0) out vec4 color;
+layout(location = 1) out float depth;
 
 struct ray {
     vec3 from;
     vec3 to;
 };
 
-// https://stackoverflow.com/questions/71731722/correct-way-to-generate-3d-world-ray-from-2d-mouse-coordinates
+// The ray is interpolated from the corners of the screen, see postprocess.vert
 vec3 get_ray() {
-    vec2 nds = ( UV - vec2(0.5) ) * 2;
-
-    vec3 ray_nds = vec3(nds, 1.0f);
-    vec4 ray_clip = vec4(nds, -1.0f, 1.0f);
-
-    vec4 ray_eye = inverse(projection) * ray_clip;
-
-    ray_eye = vec4(ray_eye.xy, -1.0f, 0.0f);
-
-    vec3 ray_wor = (inverse(view) * ray_eye).xyz;
-
-    return normalize(ray_wor);
+    return normalize(view_ray);
 }
 
-struct intersections {
-    float t1;
-    float t2;
-    bool did;
-};
-
-intersections get_sphere_intersection_t(
-    vec3 sphere_position, float sphere_radius,
-    vec3 position, vec3 direction_normal) {
-    float t = dot(sphere_position - position, direction_normal);
-
-    vec3 sphere_intersection_midpoint = position + direction_normal * t;
-    float distance_to_sphere_mid = length(sphere_intersection_midpoint - sphere_position);
-
-    if (distance_to_sphere_mid < sphere_radius) {
-        float half_intersect_length = sqrt(sphere_radius * sphere_radius
-            - distance_to_sphere_mid * distance_to_sphere_mid);
-        float t1 = t - half_intersect_length;
-        float t2 = t + half_intersect_length;
-
-        if (t1 < 0.0f && t2 < 0.0f) {
-            return intersections(0.0f, 0.0f, false);
+// Combines the four nearest reduced-resolution texels, the texels whose depth differs from the pixel's get no weight
+vec4 upsample_scattering(float pixel_depth) {
+    vec2 size = vec2(textureSize(depth_texture, 0));
+    vec2 position = UV * size - 0.5f;
+    vec2 base = floor(position);
+    vec2 fraction = position - base;
+
+    vec4 sum = vec4(0.0f);
+    float weight_sum = 0.0f;
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 2; x++) {
+            ivec2 texel = clamp(ivec2(base) + ivec2(x, y), ivec2(0), ivec2(size) - 1);
+            float bilinear = (x == 0 ? 1.0f - fraction.x : fraction.x) * (y == 0 ? 1.0f - fraction.y : fraction.y);
+
+            float depth_difference = (texelFetch(depth_texture, texel, 0).r - pixel_depth) / (0.1f * max(pixel_depth, 0.1f));
+            float weight = bilinear * max(exp(-depth_difference * depth_difference), 1e-4f);
+
+            sum += texelFetch(scattering_texture, texel, 0) * weight;
+            weight_sum += weight;
         }
-
-        return intersections(min(t1, t2), max(t1, t2), true);
     }
 
-    return intersections(0.0f, 0.0f, false);
-}
-
-float density_at_point(vec3 position) {
-    float height_above_surface = length(position - earth_position) - earth_radius;
-    float height_scaled = height_above_surface / (atmosphere_radius - earth_radius);
-    float local_density = exp(-height_scaled * density_falloff) * (1 - height_scaled);
-
-    return local_density;
+    return sum / weight_sum;
 }
 
-float optical_depth(vec3 position, vec3 light_dir, float ray_length) {
-     vec3 sample_point = position;
-     float step_size = ray_length / (number_of_optical_depths - 1);
-     float value = 0.0f;
-
-     for (int i = 0; i < number_of_optical_depths; i++) {
-        float local_density = density_at_point(sample_point);
-        value += local_density * step_size;
-        sample_point += light_dir * step_size;
-     }
+// Blends the current scattering into the history reprojected from the previous frame, the history is clamped
+// to the current neighborhood so that the disoccluded and changed areas do not leave trails
+vec4 resolve_history(vec3 ray_dir, float pixel_depth) {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    ivec2 size = textureSize(scattering_texture, 0);
+    vec4 current = texelFetch(scattering_texture, texel, 0);
+    if (!history_valid) {
+        return current;
+    }
 
-     return value;
-}
+    vec4 previous_clip = previous_view_projection * vec4(camera.position + ray_dir * pixel_depth, 1.0f);
+    vec2 previous_uv = previous_clip.xy / previous_clip.w * 0.5f + 0.5f;
+    if (previous_clip.w <= 0.0f || any(lessThan(previous_uv, vec2(0.0f))) || any(greaterThan(previous_uv, vec2(1.0f)))) {
+        return current;
+    }
 
-vec3 calculate_light(vec3 position, vec3 direction_normal, float length, vec3 orig_color) {
-    vec3 scatter_color = pow(400 / wave_lengths, vec3(4)) * scattering_strength;
-
-    vec3 scatter_point = position;
-    float step_size = length / (number_of_measurements - 1);
-    vec3 scattered_light = vec3(0.0f);
-    vec3 dir_to_sun = normalize(light.position.xyz - earth_position);
-    float view_ray_optical_depth = 0;
-
-    for (int i = 0; i < number_of_measurements; i++) {
-        intersections sun_ray_intersections = get_sphere_intersection_t(
-            earth_position, atmosphere_radius, scatter_point, dir_to_sun);
-        float sun_ray_length = 1.0f;//sun_ray_ts.t2; // We are in atmosphere
-
-        float sun_ray_optical_depth = optical_depth(
-            scatter_point, dir_to_sun, sun_ray_length);
-        view_ray_optical_depth = optical_depth(
-            scatter_point, -direction_normal, step_size * i);
-        vec3 transmittance =
-            exp(-(sun_ray_optical_depth + view_ray_optical_depth) * scatter_color);
-        float local_density = density_at_point(scatter_point);
-
-        scattered_light += local_density * transmittance * scatter_color * step_size;
-        scatter_point += direction_normal * step_size;
+    vec4 minimum = current;
+    vec4 maximum = current;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            vec4 neighbor = texelFetch(scattering_texture, clamp(texel + ivec2(x, y), ivec2(0), size - 1), 0);
+            minimum = min(minimum, neighbor);
+            maximum = max(maximum, neighbor);
+        }
     }
-    float original_color_transmittance = exp(-view_ray_optical_depth);
 
-    return orig_color * original_color_transmittance + scattered_light;
+    vec4 history = clamp(texture(history_texture, previous_uv), minimum, maximum);
+    return mix(history, current, temporal_blend);
 }
 
 void main() {
-    color = texture(renderTexture, UV);
+    if (atmosphere_pass == 0 || atmosphere_pass == 2) {
+        color = texture(renderTexture, UV);
+    } else {
+        color = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+    depth = -1.0f;
+
     vec3 ray_dir = get_ray();
 
     intersections earth_intersections = get_sphere_intersection_t(
@@ -164,10 +130,27 @@ void main() {
        distance_through_atmosphere = earth_intersections.t1 - distance_to_atmosphere;
     }
 
-    vec3 point_in_atmosphere =
-        camera.position + ray_dir * distance_to_atmosphere;
-    vec3 light = calculate_light(
-        point_in_atmosphere, ray_dir, distance_through_atmosphere, color.xyz);
-    color = vec4(light, 1.0f);
+    // The distance where the raymarching ends separates the planet, the atmosphere and the space when upsampling
+    depth = distance_to_atmosphere + distance_through_atmosphere;
+
+    vec4 light;
+    if (atmosphere_pass == 2) {
+        light = upsample_scattering(depth);
+    } else if (atmosphere_pass == 3) {
+        light = resolve_history(ray_dir, depth);
+    } else {
+        atomicCounterIncrement(marched_pixels);
+
+        vec3 point_in_atmosphere =
+            camera.position + ray_dir * distance_to_atmosphere;
+        light = calculate_light(
+            point_in_atmosphere, ray_dir, distance_through_atmosphere, gl_FragCoord.xy);
+    }
+
+    if (atmosphere_pass == 1 || atmosphere_pass == 3) {
+        color = light;
+    } else {
+        color = vec4(color.rgb * light.a + light.rgb, 1.0f);
+    }
 }
 
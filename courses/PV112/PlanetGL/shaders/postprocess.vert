@@ -1,8 +1,14 @@
 #version 450
 
+#include "include/camera.glsl"
+
 // Output data ; will be interpolated for each fragment.
 out vec2 UV;
 
+// The unnormalized world-space direction of the view ray, it is linear in the screen coordinates, so interpolating
+// it from the corners gives the exact ray of every fragment
+out vec3 view_ray;
+
 const vec2 coords[6] = {
     vec2(-1.0f, -1.0f),
     vec2( 1.0f, -1.0f),
@@ -15,5 +21,7 @@ const vec2 coords[6] = {
 void main(){
 	gl_Position = vec4(coords[gl_VertexID], 0.0f, 1.0f);
 	UV = (coords[gl_VertexID] + vec2(1, 1)) / 2.0f;
-}
 
+	vec4 ray_eye = camera.inverse_projection * vec4(coords[gl_VertexID], -1.0f, 1.0f);
+	view_ray = (camera.inverse_view * vec4(ray_eye.xy, -1.0f, 0.0f)).xyz;
+}
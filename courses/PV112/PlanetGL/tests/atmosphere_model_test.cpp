@@ -0,0 +1,123 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "atmosphere_model.hpp"
+#include "test.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/matrix_transform.hpp>
+#include <gtest/gtest.h>
+#include <random>
+#include <stb_image.h>
+
+namespace {
+/** The default parameters and the light of the space scene, as in atmosphere_thumbnail. */
+const AtmosphereParameters parameters{4.3f, 8.0f, glm::vec3(700.0f, 530.0f, 440.0f), 10};
+const glm::vec3 sun_position(10.0f, 10.0f, -10.0f);
+
+/**
+ * The largest relative difference between @link AtmosphereModel::trace_batch and @link AtmosphereModel::trace, the
+ * values below 1e-3 (about a quarter of an 8-bit step) are compared absolutely as their rounding errors are larger.
+ */
+double batch_tolerance() {
+    if (std::strcmp(AtmosphereModel::INSTRUCTION_SET, "AVX2") == 0)
+        return 3.3e-5; // FMA contraction
+    if (std::strcmp(AtmosphereModel::INSTRUCTION_SET, "SSE2") == 0)
+        return 1.5e-6;
+    return 3.5e-7;
+}
+
+/** Fills the batch with random rays around the planet, most of them aimed at the atmosphere. */
+RayBatch random_rays(std::mt19937& generator) {
+    std::uniform_real_distribution<float> unit{-1.0f, 1.0f};
+    std::uniform_real_distribution<float> distance{1.7f, 6.0f};
+    const auto random_direction = [&]() {
+        glm::vec3 direction;
+        do {
+            direction = glm::vec3(unit(generator), unit(generator), unit(generator));
+        } while (glm::length(direction) < 0.01f || glm::length(direction) > 1.0f);
+        return glm::normalize(direction);
+    };
+
+    RayBatch rays;
+    for (int lane = 0; lane < RayBatch::SIZE; lane++) {
+        const glm::vec3 origin = AtmosphereModel::EARTH_POSITION + random_direction() * distance(generator);
+        const glm::vec3 target =
+            AtmosphereModel::EARTH_POSITION + random_direction() * AtmosphereModel::ATMOSPHERE_RADIUS * 0.9f;
+        const glm::vec3 direction = lane == 0 ? random_direction() : glm::normalize(target - origin);
+        rays.origin_x[lane] = origin.x;
+        rays.origin_y[lane] = origin.y;
+        rays.origin_z[lane] = origin.z;
+        rays.direction_x[lane] = direction.x;
+        rays.direction_y[lane] = direction.y;
+        rays.direction_z[lane] = direction.z;
+    }
+    return rays;
+}
+} // namespace
+
+// Checks that the SIMD batches match the readable reference within the rounding of the approximated exponential.
+TEST(AtmosphereModelTest, TraceBatchMatchesTrace) {
+    const AtmosphereModel model(parameters, sun_position);
+    const double tolerance = batch_tolerance();
+    std::mt19937 generator{112};
+
+    double max_error = 0.0;
+    for (int batch = 0; batch < 2000; batch++) {
+        const RayBatch rays = random_rays(generator);
+        LightBatch light;
+        model.trace_batch(rays, 10, light);
+
+        for (int lane = 0; lane < RayBatch::SIZE; lane++) {
+            const glm::vec3 origin(rays.origin_x[lane], rays.origin_y[lane], rays.origin_z[lane]);
+            const glm::vec3 direction(rays.direction_x[lane], rays.direction_y[lane], rays.direction_z[lane]);
+            const glm::vec4 expected = model.trace(origin, direction, 10);
+            const glm::vec4 actual(light.red[lane], light.green[lane], light.blue[lane], light.transmittance[lane]);
+            for (int c = 0; c < 4; c++) {
+                const double difference = std::abs(double(actual[c]) - double(expected[c]));
+                const double error = difference / std::max(std::abs(double(expected[c])), 1e-3);
+                max_error = std::max(max_error, error);
+            }
+        }
+    }
+    EXPECT_LE(max_error, tolerance) << AtmosphereModel::INSTRUCTION_SET;
+}
+
+// Compares render() with the image written by 'atmosphere_thumbnail atmosphere_64x48.png 64 48 10 4', the reference
+// for the later changes of the scattering in the shader.
+TEST(AtmosphereModelTest, RenderMatchesGoldenImage) {
+    const int width = 64;
+    const int height = 48;
+    const AtmosphereModel model(parameters, sun_position);
+    const glm::vec3 eye = AtmosphereModel::EARTH_POSITION + glm::vec3(0.0f, 0.0f, 4.0f);
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f), float(width) / float(height), 0.01f, 1000.0f);
+    const glm::mat4 view = glm::lookAt(eye, AtmosphereModel::EARTH_POSITION, glm::vec3(0.0f, 1.0f, 0.0f));
+    const std::vector<float> light = model.render(width, height, projection, view, 10);
+
+    const std::filesystem::path path = get_data_path() / "atmosphere_64x48.png";
+    int golden_width, golden_height, channels;
+    unsigned char* golden = stbi_load(path.generic_string().data(), &golden_width, &golden_height, &channels, 3);
+    ASSERT_NE(golden, nullptr) << path;
+    ASSERT_EQ(golden_width, width);
+    ASSERT_EQ(golden_height, height);
+
+    // The golden image is quantized to 8 bits with the rows from the top, the instruction sets may round differently.
+    int max_difference = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const float* source = light.data() + (size_t(height - 1 - y) * width + x) * 4;
+            const unsigned char* expected = golden + (size_t(y) * width + x) * 3;
+            for (int c = 0; c < 3; c++) {
+                const int actual = static_cast<int>(std::clamp(source[c], 0.0f, 1.0f) * 255.0f + 0.5f);
+                max_difference = std::max(max_difference, std::abs(actual - int(expected[c])));
+            }
+        }
+    }
+    stbi_image_free(golden);
+    EXPECT_LE(max_difference, 1);
+}
@@ -0,0 +1,65 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "block_compression.hpp"
+#include "test.hpp"
+#include <gtest/gtest.h>
+#include <stb_image.h>
+
+namespace {
+/** The lowest PSNR (in dB) of the BC1 compressed fixture image (it was 40.8 dB when written). */
+const double bc1_psnr_floor = 38.0;
+
+/** The lowest PSNR (in dB) of the BC3 compressed fixture image (it was 42.1 dB when written). */
+const double bc3_psnr_floor = 39.0;
+
+/** The lowest PSNR (in dB) accepted for the smaller levels, they are dense in detail, so they compress worse. */
+const double mipmap_psnr_floor = 20.0;
+
+/** Loads the fixture image as RGBA8, optionally replacing its alpha channel with a diagonal gradient. */
+std::vector<unsigned char> load_fixture(int& width, int& height, bool alpha) {
+    const std::filesystem::path path = get_lecture_path() / "images" / "airplane.jpg";
+    int channels;
+    unsigned char* pixels = stbi_load(path.generic_string().data(), &width, &height, &channels, 4);
+    if (!pixels) {
+        return {};
+    }
+
+    std::vector<unsigned char> image(pixels, pixels + size_t(width) * height * 4);
+    stbi_image_free(pixels);
+
+    if (alpha) {
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                image[(size_t(y) * width + x) * 4 + 3] = static_cast<unsigned char>(255 * (x + y) / (width + height));
+            }
+        }
+    }
+    return image;
+}
+
+/** Compresses the fixture image and checks the format and the quality of its levels. */
+void check_compression(bool alpha, uint32_t format, double psnr_floor) {
+    int width, height;
+    const std::vector<unsigned char> pixels = load_fixture(width, height, alpha);
+    ASSERT_FALSE(pixels.empty());
+
+    const MipChain image = build_mip_chain(width, height, pixels.data());
+    const CompressedImage compressed = compress_image(image);
+
+    EXPECT_EQ(compressed.format, format);
+    ASSERT_EQ(compressed.levels.size(), image.levels.size());
+    EXPECT_GE(compute_psnr(image, compressed), psnr_floor);
+    for (size_t level = 1; level < compressed.levels.size(); level++) {
+        EXPECT_GE(compute_psnr(image, compressed, level), mipmap_psnr_floor) << "level " << level;
+    }
+}
+} // namespace
+
+TEST(BlockCompressionTest, OpaqueImageUsesBC1) { check_compression(false, CompressedImage::BC1, bc1_psnr_floor); }
+
+TEST(BlockCompressionTest, TransparentImageUsesBC3) { check_compression(true, CompressedImage::BC3, bc3_psnr_floor); }
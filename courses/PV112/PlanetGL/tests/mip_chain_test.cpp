@@ -0,0 +1,83 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "mip_chain.hpp"
+#include <cmath>
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+/** Encodes a linear value into an 8-bit sRGB value. */
+int encode_srgb(double linear) {
+    const double srgb = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+    return static_cast<int>(std::lround(srgb * 255.0));
+}
+
+/** Returns an RGBA8 image filled with random pixels. */
+std::vector<unsigned char> random_image(int width, int height, unsigned int seed) {
+    std::mt19937 generator{seed};
+    std::uniform_int_distribution<int> distribution{0, 255};
+    std::vector<unsigned char> pixels(size_t(width) * height * 4);
+    for (unsigned char& value : pixels) {
+        value = static_cast<unsigned char>(distribution(generator));
+    }
+    return pixels;
+}
+} // namespace
+
+// Checks that every level halves the previous one (rounding down, at least 1) and that the levels are packed tightly.
+TEST(MipChainTest, LevelSizes) {
+    const std::vector<unsigned char> image = random_image(37, 10, 1);
+    const MipChain chain = build_mip_chain(37, 10, image.data());
+
+    const std::vector<std::pair<int, int>> expected = {{37, 10}, {18, 5}, {9, 2}, {4, 1}, {2, 1}, {1, 1}};
+    ASSERT_EQ(chain.levels.size(), expected.size());
+
+    size_t offset = 0;
+    for (size_t level = 0; level < expected.size(); level++) {
+        EXPECT_EQ(chain.levels[level].width, expected[level].first) << "level " << level;
+        EXPECT_EQ(chain.levels[level].height, expected[level].second) << "level " << level;
+        EXPECT_EQ(chain.levels[level].offset, offset) << "level " << level;
+        offset += size_t(expected[level].first) * expected[level].second * 4;
+    }
+    EXPECT_EQ(chain.pixels.size(), offset);
+    EXPECT_TRUE(std::equal(image.begin(), image.end(), chain.pixels.begin()));
+}
+
+// Checks that a black and white 2x2 block averages to the middle gray in linear space rather than in sRGB.
+TEST(MipChainTest, AveragesInLinearSpace) {
+    // Black and white pixels on the diagonals, fully opaque and fully transparent pixels in the alpha channel.
+    const std::vector<unsigned char> image = {0, 0, 0, 255, 255, 255, 255, 0, 255, 255, 255, 0, 0, 0, 0, 255};
+
+    const MipChain srgb = build_mip_chain(2, 2, image.data(), true);
+    ASSERT_EQ(srgb.levels.size(), 2u);
+    const unsigned char* average = srgb.data(1);
+    for (int c = 0; c < 3; c++) {
+        EXPECT_NEAR(average[c], encode_srgb(0.5), 1) << "channel " << c;
+    }
+    EXPECT_NEAR(average[3], 128, 1);
+
+    // Without the gamma correction all channels are averaged as they are.
+    const MipChain linear = build_mip_chain(2, 2, image.data(), false);
+    for (int c = 0; c < 4; c++) {
+        EXPECT_NEAR(linear.data(1)[c], 128, 1) << "channel " << c;
+    }
+}
+
+// Checks that the vectorized filter produces exactly the same levels as the scalar one, including the odd sizes whose
+// last column or row is clamped.
+TEST(MipChainTest, SimdMatchesScalar) {
+    const std::vector<std::pair<int, int>> sizes = {{1, 1}, {1, 7}, {7, 1}, {3, 5}, {37, 21}, {129, 65}, {256, 256}};
+    for (const auto& [width, height] : sizes) {
+        const std::vector<unsigned char> image = random_image(width, height, unsigned(width * 1000 + height));
+        for (const bool gamma_correct : {true, false}) {
+            const MipChain simd = build_mip_chain(width, height, image.data(), gamma_correct, MipKernel::SIMD);
+            const MipChain scalar = build_mip_chain(width, height, image.data(), gamma_correct, MipKernel::SCALAR);
+            EXPECT_EQ(simd.pixels, scalar.pixels) << width << "x" << height << (gamma_correct ? " sRGB" : " linear");
+        }
+    }
+}
@@ -0,0 +1,54 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "obj_parser.hpp"
+#include "test.hpp"
+#include <gtest/gtest.h>
+
+namespace {
+/** The models of the lecture together with the numbers of threads the parser is allowed to use. */
+class ObjParserTest : public testing::TestWithParam<std::tuple<const char*, unsigned int>> {};
+} // namespace
+
+// Checks that the parallel parser produces exactly the output of tinyobj::ObjReader, regardless of the chunking.
+TEST_P(ObjParserTest, MatchesTinyObj) {
+    const auto [name, threads_count] = GetParam();
+    const std::filesystem::path path = get_lecture_path() / "objects" / name;
+
+    tinyobj::ObjReader reader;
+    ASSERT_TRUE(reader.ParseFromFile(path.string())) << reader.Error();
+    const tinyobj::attrib_t& attrib = reader.GetAttrib();
+
+    const ObjParser::Result result = ObjParser::parse(path, threads_count);
+    ASSERT_TRUE(result.valid) << result.warning;
+
+    EXPECT_EQ(result.vertices, attrib.vertices);
+    EXPECT_EQ(result.normals, attrib.normals);
+    EXPECT_EQ(result.texcoords, attrib.texcoords);
+
+    // The parser splits the shapes at material changes as well, so only the concatenated triangles are compared.
+    std::vector<tinyobj::index_t> expected;
+    for (const tinyobj::shape_t& shape : reader.GetShapes()) {
+        expected.insert(expected.end(), shape.mesh.indices.begin(), shape.mesh.indices.end());
+    }
+    ASSERT_EQ(result.indices.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQ(result.indices[i].vertex_index, expected[i].vertex_index) << "index " << i;
+        ASSERT_EQ(result.indices[i].normal_index, expected[i].normal_index) << "index " << i;
+        ASSERT_EQ(result.indices[i].texcoord_index, expected[i].texcoord_index) << "index " << i;
+    }
+
+    size_t shape_indices = 0;
+    for (const ObjParser::Shape& shape : result.shapes) {
+        EXPECT_EQ(shape.first_index, shape_indices);
+        shape_indices += shape.indices_count;
+    }
+    EXPECT_EQ(shape_indices, result.indices.size());
+}
+
+INSTANTIATE_TEST_SUITE_P(Models, ObjParserTest,
+                         testing::Combine(testing::Values("rocket.obj", "nature.obj", "room.obj"), testing::Values(1u, 3u, 8u)));
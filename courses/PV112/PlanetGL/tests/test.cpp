@@ -0,0 +1,29 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "test.hpp"
+#include "configuration.h"
+#include <gtest/gtest.h>
+
+namespace {
+std::filesystem::path lecture_path;
+std::filesystem::path data_path;
+} // namespace
+
+const std::filesystem::path& get_lecture_path() { return lecture_path; }
+
+const std::filesystem::path& get_data_path() { return data_path; }
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+
+    Configuration configuration{argv[0]};
+    lecture_path = configuration.get_path("test_dir").parent_path();
+    data_path = configuration.get_path("data");
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,16 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include <filesystem>
+
+/** Returns the directory of the lecture (with 'objects', 'images' and 'tests'), read from 'configuration.toml'. */
+const std::filesystem::path& get_lecture_path();
+
+/** Returns the directory with the expected outputs of the tests (golden images), read from 'configuration.toml'. */
+const std::filesystem::path& get_data_path();
@@ -0,0 +1,136 @@
+#include "texture_cache.hpp"
+#include "code_utils.h"
+
+#include <iostream>
+
+// ----------------------------------------------------------------------------
+// Texture
+// ----------------------------------------------------------------------------
+
+Texture::~Texture() {
+    if (name) {
+        glDeleteTextures(1, &name);
+        cache->resident_count--;
+        cache->resident_bytes -= size;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// TextureCache
+// ----------------------------------------------------------------------------
+
+size_t TextureCache::KeyHash::operator()(const Key& key) const {
+    size_t seed = 0;
+    CodeUtils::hash_combine(seed, key.path);
+    CodeUtils::hash_combine(seed, key.parameters.internal_format);
+    CodeUtils::hash_combine(seed, key.parameters.compressed);
+    CodeUtils::hash_combine(seed, key.parameters.min_filter);
+    CodeUtils::hash_combine(seed, key.parameters.mag_filter);
+    CodeUtils::hash_combine(seed, key.parameters.wrap);
+    return seed;
+}
+
+std::shared_ptr<Texture> TextureCache::get(const std::filesystem::path& path,
+                                           const TextureParameters& requested_parameters) {
+    // Falls back to the uncompressed format if the driver cannot sample the compressed one.
+    TextureParameters parameters = requested_parameters;
+    parameters.compressed = parameters.compressed && supports_compression();
+
+    // Different spellings of the same file share the texture.
+    std::error_code error;
+    const std::filesystem::path canonical_path = std::filesystem::weakly_canonical(path, error);
+    const Key key{(error ? path : canonical_path).generic_string(), parameters};
+
+    if (const auto entry = textures.find(key); entry != textures.end()) {
+        if (std::shared_ptr<Texture> texture = entry->second.lock()) {
+            hits++;
+            return texture;
+        }
+    }
+
+    // The entries of the released textures are dropped here, so the map does not grow with every image ever used.
+    misses++;
+    std::erase_if(textures, [](const auto& entry) { return entry.second.expired(); });
+    const std::shared_ptr<Texture> texture = std::make_shared<Texture>(this);
+    textures[key] = texture;
+
+    const std::weak_ptr<Texture> weak_texture = texture;
+    loader.load_texture(path, parameters.compressed, [this, parameters, weak_texture](const auto& image) {
+        // Nobody needs the texture anymore if all objects using it were destroyed in the meantime.
+        if (const std::shared_ptr<Texture> texture = weak_texture.lock()) {
+            upload(*texture, parameters, image);
+        }
+    });
+
+    return texture;
+}
+
+void TextureCache::upload(Texture& texture, const TextureParameters& parameters,
+                          const AssetLoader::TextureImage& image) {
+    // Textures that are not mipmapped need only the first level.
+    const bool mipmapped = parameters.min_filter != GL_LINEAR && parameters.min_filter != GL_NEAREST;
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture.name);
+    texture.size = 0;
+
+    // The levels are tightly packed, the default alignment of 4 bytes matches the RGBA8 rows.
+    if (const MipChain* chain = std::get_if<MipChain>(&image)) {
+        const GLsizei levels = mipmapped ? static_cast<GLsizei>(chain->levels.size()) : 1;
+        glTextureStorage2D(texture.name, levels, parameters.internal_format, chain->width(), chain->height());
+
+        for (GLsizei level = 0; level < levels; level++) {
+            const MipChain::Level& mip = chain->levels[level];
+            glTextureSubImage2D(texture.name,
+                                level,                     //
+                                0, 0,                      //
+                                mip.width, mip.height,     //
+                                GL_RGBA, GL_UNSIGNED_BYTE, //
+                                chain->data(level));
+            texture.size += size_t(mip.width) * size_t(mip.height) * 4;
+        }
+
+        texture.width = chain->width();
+        texture.height = chain->height();
+    } else {
+        const CompressedImage& compressed = std::get<CompressedImage>(image);
+        const GLsizei levels = mipmapped ? static_cast<GLsizei>(compressed.levels.size()) : 1;
+        glTextureStorage2D(texture.name, levels, compressed.format, compressed.width(), compressed.height());
+
+        for (GLsizei level = 0; level < levels; level++) {
+            const CompressedImage::Level& mip = compressed.levels[level];
+            glCompressedTextureSubImage2D(texture.name,
+                                          level,                   //
+                                          0, 0,                    //
+                                          mip.width, mip.height,   //
+                                          compressed.format,       //
+                                          static_cast<GLsizei>(mip.size), compressed.data(level));
+            texture.size += mip.size;
+        }
+
+        texture.width = compressed.width();
+        texture.height = compressed.height();
+    }
+
+    glTextureParameteri(texture.name, GL_TEXTURE_MIN_FILTER, parameters.min_filter);
+    glTextureParameteri(texture.name, GL_TEXTURE_MAG_FILTER, parameters.mag_filter);
+    glTextureParameteri(texture.name, GL_TEXTURE_WRAP_S, parameters.wrap);
+    glTextureParameteri(texture.name, GL_TEXTURE_WRAP_T, parameters.wrap);
+
+    resident_count++;
+    resident_bytes += texture.size;
+}
+
+bool TextureCache::supports_compression() {
+    if (!compression_supported) {
+        // The S3TC formats are an extension, the core query reports whether the driver accepts them.
+        GLint bc1_supported = GL_FALSE;
+        GLint bc3_supported = GL_FALSE;
+        glGetInternalformativ(GL_TEXTURE_2D, CompressedImage::BC1, GL_INTERNALFORMAT_SUPPORTED, 1, &bc1_supported);
+        glGetInternalformativ(GL_TEXTURE_2D, CompressedImage::BC3, GL_INTERNALFORMAT_SUPPORTED, 1, &bc3_supported);
+        compression_supported = bc1_supported == GL_TRUE && bc3_supported == GL_TRUE;
+        if (!*compression_supported) {
+            std::cerr << "TextureCache: BC1/BC3 is not supported, textures stay uncompressed" << std::endl;
+        }
+    }
+    return *compression_supported;
+}
@@ -0,0 +1,158 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include "asset_loader.hpp"
+#include "glad/glad.h"
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+class TextureCache;
+
+/** The parameters of a texture that are part of the cache key, i.e., its format and sampling. */
+struct TextureParameters {
+    /** The format of uncompressed textures. */
+    GLenum internal_format = GL_RGBA8;
+    /** True to store the texture in BC1/BC3 blocks (if supported by the driver) instead of {@link internal_format}. */
+    bool compressed = true;
+    GLenum min_filter = GL_LINEAR_MIPMAP_LINEAR;
+    GLenum mag_filter = GL_LINEAR;
+    GLenum wrap = GL_REPEAT;
+
+    bool operator==(const TextureParameters& other) const = default;
+};
+
+/**
+ * A texture shared through the {@link TextureCache}. The OpenGL texture is deleted when the last reference is released.
+ * The name is 0 until the image is loaded and uploaded.
+ */
+class Texture {
+    friend class TextureCache;
+
+    // ----------------------------------------------------------------------------
+    // Variables
+    // ----------------------------------------------------------------------------
+public:
+    /** The name of the OpenGL texture, or 0 if the texture is not uploaded yet. */
+    GLuint name = 0;
+
+    int width = 0;
+    int height = 0;
+
+    /** The size of all mipmap levels in the video memory (in bytes). */
+    size_t size = 0;
+
+private:
+    /** The cache whose statistics are updated when the texture is released. */
+    TextureCache* cache;
+
+    // ----------------------------------------------------------------------------
+    // Constructors & Destructors
+    // ----------------------------------------------------------------------------
+public:
+    explicit Texture(TextureCache* cache)
+        : cache(cache) {}
+
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+
+    ~Texture();
+};
+
+/**
+ * The cache of textures keyed by the canonical path of the image and the texture parameters. Every image is decoded
+ * and uploaded only once no matter how many objects use it, the objects share the returned handles. The cache keeps
+ * only weak references, so a texture is released as soon as no object uses it, and its entry is removed by the next
+ * miss.
+ * <p>
+ * The cache must outlive all textures it returned.
+ */
+class TextureCache {
+    friend class Texture;
+
+    // ----------------------------------------------------------------------------
+    // Nested Types
+    // ----------------------------------------------------------------------------
+private:
+    struct Key {
+        std::string path;
+        TextureParameters parameters;
+
+        bool operator==(const Key& other) const = default;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    // ----------------------------------------------------------------------------
+    // Variables
+    // ----------------------------------------------------------------------------
+public:
+    /** The number of requests served by an already loaded (or loading) texture. */
+    size_t hits = 0;
+
+    /** The number of requests that had to load the image. */
+    size_t misses = 0;
+
+    /** The number of textures currently stored in the video memory. */
+    size_t resident_count = 0;
+
+    /** The size of the textures currently stored in the video memory (in bytes). */
+    size_t resident_bytes = 0;
+
+private:
+    /** The loader decoding the images in the background. */
+    AssetLoader& loader;
+
+    std::unordered_map<Key, std::weak_ptr<Texture>, KeyHash> textures;
+
+    /** Whether the driver supports the BC1 and BC3 formats, queried when the first texture is requested. */
+    std::optional<bool> compression_supported;
+
+    // ----------------------------------------------------------------------------
+    // Constructors
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Creates a new @link TextureCache.
+     *
+     * @param 	loader	The loader used to decode the images in the background.
+     */
+    explicit TextureCache(AssetLoader& loader)
+        : loader(loader) {}
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // ----------------------------------------------------------------------------
+    // Methods
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Returns the texture loaded from the specified image. The image is loaded in the background if it is not in the
+     * cache yet, the returned texture gets its name once it is uploaded. Compressed textures are stored uncompressed if
+     * the driver does not support the compressed formats.
+     *
+     * @param 	path				The path to the image.
+     * @param 	requested_parameters	The format and the sampling parameters of the texture.
+     * @return	The shared texture.
+     */
+    std::shared_ptr<Texture> get(const std::filesystem::path& path, const TextureParameters& requested_parameters = {});
+
+private:
+    /** Creates the OpenGL texture from the loaded image and its mipmap levels. */
+    void upload(Texture& texture, const TextureParameters& parameters, const AssetLoader::TextureImage& image);
+
+    /** Checks whether the driver supports the BC1 and BC3 formats. */
+    bool supports_compression();
+};
@@ -0,0 +1,68 @@
+#include "transmittance_lut.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// ----------------------------------------------------------------------------
+// Constructors & Destructors
+// ----------------------------------------------------------------------------
+
+TransmittanceLut::~TransmittanceLut() { glDeleteTextures(1, &texture); }
+
+// ----------------------------------------------------------------------------
+// Methods
+// ----------------------------------------------------------------------------
+
+bool TransmittanceLut::update(const AtmosphereParameters& parameters) {
+    if (this->parameters == parameters) {
+        return false;
+    }
+    this->parameters = parameters;
+
+    if (!texture) {
+        glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+        glTextureStorage2D(texture, 1, GL_RGBA32F, ANGLE_SIZE, HEIGHT_SIZE);
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    const std::vector<float> values = compute(parameters);
+    glTextureSubImage2D(texture, 0, 0, 0, ANGLE_SIZE, HEIGHT_SIZE, GL_RGBA, GL_FLOAT, values.data());
+
+    return true;
+}
+
+std::vector<float> TransmittanceLut::compute(const AtmosphereParameters& parameters) {
+    const glm::vec3 scatter_color = glm::pow(400.0f / parameters.wave_lengths, glm::vec3(4.0f)) * parameters.scattering_strength;
+
+    // The optical depths do not depend on the position of the sun
+    const AtmosphereModel model(parameters, AtmosphereModel::EARTH_POSITION + glm::vec3(0.0f, 1.0f, 0.0f));
+
+    std::vector<float> values(size_t(ANGLE_SIZE) * HEIGHT_SIZE * 4);
+    for (int y = 0; y < HEIGHT_SIZE; y++) {
+        // The ray starts above the center of the earth, the sun is in the x-y plane.
+        const float height = float(y) / float(HEIGHT_SIZE - 1);
+        const float radius = AtmosphereModel::EARTH_RADIUS
+            + (AtmosphereModel::ATMOSPHERE_RADIUS - AtmosphereModel::EARTH_RADIUS) * height;
+
+        for (int x = 0; x < ANGLE_SIZE; x++) {
+            const float sun_cos = -1.0f + 2.0f * float(x) / float(ANGLE_SIZE - 1);
+            const float sun_sin = std::sqrt(std::max(0.0f, 1.0f - sun_cos * sun_cos));
+
+            const float optical_depth =
+                model.optical_depth(AtmosphereModel::EARTH_POSITION + glm::vec3(0.0f, radius, 0.0f),
+                                    glm::vec3(sun_sin, sun_cos, 0.0f), AtmosphereModel::SUN_RAY_LENGTH);
+
+            const glm::vec3 transmittance = glm::exp(-optical_depth * scatter_color);
+            float* texel = values.data() + (size_t(y) * ANGLE_SIZE + x) * 4;
+            texel[0] = transmittance.r;
+            texel[1] = transmittance.g;
+            texel[2] = transmittance.b;
+            texel[3] = 1.0f;
+        }
+    }
+
+    return values;
+}
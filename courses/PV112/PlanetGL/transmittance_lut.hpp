@@ -0,0 +1,81 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include "atmosphere_model.hpp"
+#include "glad/glad.h"
+#include <glm/glm.hpp>
+#include <optional>
+#include <vector>
+
+/**
+ * The lookup texture of the transmittance of the atmosphere along the sun rays, used by shaders/include/scattering.glsl
+ * instead of integrating the optical depth towards the sun for every sample.
+ * <p>
+ * The atmosphere is spherically symmetric, so the optical depth of a sun ray depends only on the height of its origin
+ * and the cosine of the angle between the sun and the zenith. The texture is indexed by the cosine in [-1, 1] (x) and
+ * the height scaled to [0, 1] between the surface and the top of the atmosphere (y), and stores the RGB transmittance
+ * exp(-optical_depth * scatter_color).
+ */
+class TransmittanceLut {
+
+    // ----------------------------------------------------------------------------
+    // Static Variables
+    // ----------------------------------------------------------------------------
+public:
+    /** The number of texels along the sun zenith cosine. */
+    static const int ANGLE_SIZE = 256;
+
+    /** The number of texels along the height. */
+    static const int HEIGHT_SIZE = 128;
+
+    // ----------------------------------------------------------------------------
+    // Variables
+    // ----------------------------------------------------------------------------
+private:
+    /** The name of the OpenGL texture. */
+    GLuint texture = 0;
+
+    /** The parameters the texture was computed for, nothing before the first update. */
+    std::optional<AtmosphereParameters> parameters;
+
+    // ----------------------------------------------------------------------------
+    // Constructors & Destructors
+    // ----------------------------------------------------------------------------
+public:
+    TransmittanceLut() = default;
+
+    TransmittanceLut(const TransmittanceLut&) = delete;
+    TransmittanceLut& operator=(const TransmittanceLut&) = delete;
+
+    ~TransmittanceLut();
+
+    // ----------------------------------------------------------------------------
+    // Methods
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Recomputes the texture if the parameters changed since the last update.
+     *
+     * @param 	parameters	The current parameters of the atmosphere.
+     * @return	True if the texture was recomputed.
+     */
+    bool update(const AtmosphereParameters& parameters);
+
+    /** Returns the name of the OpenGL texture (0 before the first update). */
+    GLuint get_texture() const { return texture; }
+
+    /**
+     * Computes the RGBA transmittance of all texels without touching OpenGL, the rows go from the surface to the top of
+     * the atmosphere. The optical depth is integrated by @link AtmosphereModel::optical_depth.
+     *
+     * @param 	parameters	The parameters of the atmosphere.
+     * @return	ANGLE_SIZE * HEIGHT_SIZE RGBA values.
+     */
+    static std::vector<float> compute(const AtmosphereParameters& parameters);
+};
@@ -0,0 +1,94 @@
+#include "uniform_ring.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+/** Returns GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT of the current context, 256 (the largest allowed) if it is unknown. */
+GLsizeiptr uniform_offset_alignment() {
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    return alignment > 0 ? alignment : 256;
+}
+} // namespace
+
+// ----------------------------------------------------------------------------
+// Constructors & Destructors
+// ----------------------------------------------------------------------------
+
+UniformRing::UniformRing(GLsizeiptr region_size) {
+    alignment = uniform_offset_alignment();
+    this->region_size = (region_size + alignment - 1) / alignment * alignment;
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, FRAMES * this->region_size, nullptr, flags);
+    mapped = static_cast<std::byte*>(glMapNamedBufferRange(buffer, 0, FRAMES * this->region_size, flags));
+}
+
+UniformRing::~UniformRing() {
+    for (GLsync fence : fences)
+        glDeleteSync(fence);
+
+    glUnmapNamedBuffer(buffer);
+    glDeleteBuffers(1, &buffer);
+}
+
+// ----------------------------------------------------------------------------
+// Methods
+// ----------------------------------------------------------------------------
+
+void UniformRing::begin_frame() {
+    region = (region + 1) % FRAMES;
+    offset = 0;
+
+    GLsync& fence = fences[region];
+    if (!fence)
+        return;
+
+    // The first wait flushes the commands, so the fence is guaranteed to signal
+    GLbitfield wait_flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (true) {
+        const GLenum status = glClientWaitSync(fence, wait_flags, 1000000);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED || status == GL_WAIT_FAILED)
+            break;
+        wait_flags = 0;
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void UniformRing::end_frame() {
+    glDeleteSync(fences[region]);
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GLsizeiptr UniformRing::blocks_size(size_t count, GLsizeiptr size, GLsizeiptr alignment) {
+    if (alignment <= 0)
+        alignment = uniform_offset_alignment();
+
+    return GLsizeiptr(count) * ((size + alignment - 1) / alignment * alignment);
+}
+
+bool UniformRing::fits(GLsizeiptr size, GLsizeiptr alignment) const {
+    if (alignment <= 0)
+        alignment = this->alignment;
+
+    return (offset + alignment - 1) / alignment * alignment + size <= region_size;
+}
+
+GLintptr UniformRing::push(const void* data, GLsizeiptr size, GLsizeiptr alignment) {
+    if (alignment <= 0)
+        alignment = this->alignment;
+
+    const GLsizeiptr start = (offset + alignment - 1) / alignment * alignment;
+    if (start + size > region_size)
+        throw std::runtime_error("The uniform ring is full, increase its region size.");
+
+    const GLintptr block = GLintptr(region) * region_size + start;
+    std::memcpy(mapped + block, data, size_t(size));
+    offset = start + size;
+
+    return block;
+}
@@ -0,0 +1,108 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include "glad/glad.h"
+#include <array>
+#include <cstddef>
+
+/**
+ * The per-frame uniform data written into one persistently and coherently mapped buffer, so that the uniform blocks
+ * of the drawn objects need no buffer allocations or uploads by the driver.
+ * <p>
+ * The buffer is split into {@link FRAMES} regions used round-robin. Every frame appends its blocks to its region and
+ * binds them by their offsets, the fence placed at the end of the frame guards the region until the GPU has read it,
+ * i.e., {@link begin_frame} waits only if the GPU is more than two frames behind.
+ */
+class UniformRing {
+
+    // ----------------------------------------------------------------------------
+    // Static Variables
+    // ----------------------------------------------------------------------------
+public:
+    /** The number of frames the buffer is split into. */
+    static const int FRAMES = 3;
+
+    // ----------------------------------------------------------------------------
+    // Variables
+    // ----------------------------------------------------------------------------
+private:
+    /** The name of the OpenGL buffer. */
+    GLuint buffer = 0;
+
+    /** The mapped buffer. */
+    std::byte* mapped = nullptr;
+
+    /** The size of a region in bytes. */
+    GLsizeiptr region_size;
+
+    /** The alignment of the offsets, GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT. */
+    GLsizeiptr alignment = 256;
+
+    /** The fences of the frames that last wrote into the regions, null if there is none. */
+    std::array<GLsync, FRAMES> fences{};
+
+    /** The region of the current frame. */
+    int region = 0;
+
+    /** The offset of the next block inside the region. */
+    GLsizeiptr offset = 0;
+
+    // ----------------------------------------------------------------------------
+    // Constructors & Destructors
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Constructs a new {@link UniformRing}.
+     *
+     * @param 	region_size	The number of bytes available to a frame.
+     */
+    explicit UniformRing(GLsizeiptr region_size);
+
+    UniformRing(const UniformRing&) = delete;
+    UniformRing& operator=(const UniformRing&) = delete;
+
+    ~UniformRing();
+
+    // ----------------------------------------------------------------------------
+    // Methods
+    // ----------------------------------------------------------------------------
+public:
+    /** Switches to the next region, waiting until the GPU has finished the frame that wrote it before. */
+    void begin_frame();
+
+    /** Places the fence guarding the region of the current frame, it must follow the last draw using it. */
+    void end_frame();
+
+    /**
+     * Copies a uniform block into the region of the current frame.
+     *
+     * @param 	data	 	The data of the block.
+     * @param 	size	 	The size of the block in bytes.
+     * @param 	alignment	The alignment of the block, 0 for GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT. The data that is only
+     * 					 	copied or read as draw commands needs just 4 bytes.
+     * @return	The offset of the block in the buffer, to be bound by glBindBufferRange.
+     */
+    GLintptr push(const void* data, GLsizeiptr size, GLsizeiptr alignment = 0);
+
+    /**
+     * Returns the region size that fits the specified number of blocks, i.e., the count times the size of a block
+     * rounded up to the alignment. It queries the current context if the alignment is 0.
+     *
+     * @param 	count	 	The number of blocks.
+     * @param 	size	 	The size of a block in bytes.
+     * @param 	alignment	The alignment of the blocks, 0 for GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+     */
+    static GLsizeiptr blocks_size(size_t count, GLsizeiptr size, GLsizeiptr alignment = 0);
+
+    /** Checks whether a block of the specified size and alignment still fits into the region of the current frame. */
+    bool fits(GLsizeiptr size, GLsizeiptr alignment = 0) const;
+
+    /** Returns the name of the OpenGL buffer. */
+    GLuint get_buffer() const { return buffer; }
+};
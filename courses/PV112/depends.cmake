@@ -8,4 +8,4 @@
 ################################################################################
 
 # The list of internal dependencies using "<ModuleName>_MODULE" format.
-set(dependencies PV112_MODULE GEOMETRY_MODULE GEOMETRY_4_5_MODULE GUI_MODULE)
+set(dependencies PV112_MODULE GEOMETRY_MODULE GEOMETRY_4_5_MODULE GUI_MODULE ATMOSPHERE_MODULE)
@@ -0,0 +1,11 @@
+################################################################################
+# Common Framework for Computer Graphics Courses at FI MUNI.
+#
+# Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+# All rights reserved.
+#
+# The CMake file defining dependencies for the current module.
+################################################################################
+
+# The list of internal dependencies using "<ModuleName>_MODULE" format.
+set(dependencies GLM_MODULE)
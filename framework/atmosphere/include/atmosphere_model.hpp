@@ -0,0 +1,181 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/** The parameters of the atmosphere the scattering depends on, i.e., the sliders of the atmosphere menu. */
+struct AtmosphereParameters {
+    float density_falloff;
+    float scattering_strength;
+    glm::vec3 wave_lengths;
+    int number_of_optical_depths;
+
+    bool operator==(const AtmosphereParameters& other) const = default;
+};
+
+/** The origins and the directions of the rays traced together by @link AtmosphereModel::trace_batch. */
+struct RayBatch {
+    /** The number of rays in a batch, i.e., the number of AVX2 lanes. */
+    static const int SIZE = 8;
+
+    alignas(32) float origin_x[SIZE];
+    alignas(32) float origin_y[SIZE];
+    alignas(32) float origin_z[SIZE];
+    alignas(32) float direction_x[SIZE];
+    alignas(32) float direction_y[SIZE];
+    alignas(32) float direction_z[SIZE];
+};
+
+/** The scattered light and the transmittance of the original color computed by @link AtmosphereModel::trace_batch. */
+struct LightBatch {
+    alignas(32) float red[RayBatch::SIZE];
+    alignas(32) float green[RayBatch::SIZE];
+    alignas(32) float blue[RayBatch::SIZE];
+    alignas(32) float transmittance[RayBatch::SIZE];
+};
+
+/**
+ * The CPU implementation of the atmospheric scattering of PlanetGL (shaders/include/scattering.glsl), used as the
+ * reference the shader optimizations are compared against and as an offline renderer that does not need a GPU.
+ * <p>
+ * The model follows the full-resolution pass of the shader, except that the transmittance along the sun rays is
+ * integrated for every measurement instead of being looked up, i.e., it is what the lookup texture approximates.
+ * The rays are traced either one by one (the readable reference) or in batches of @link RayBatch::SIZE rays using
+ * AVX2, SSE2, or scalar lanes depending on the instruction set the module is compiled for.
+ */
+class AtmosphereModel {
+
+    // ----------------------------------------------------------------------------
+    // Static Variables
+    // ----------------------------------------------------------------------------
+public:
+    // The geometry of the planet, the shaders declare the same constants in shaders/include/atmosphere.glsl
+
+    /** The center of the earth. */
+    static constexpr glm::vec3 EARTH_POSITION{0.0f, 0.0f, 1.0f};
+
+    /** The radius of the earth. */
+    static constexpr float EARTH_RADIUS = 1.0f;
+
+    /** The radius of the top of the atmosphere. */
+    static constexpr float ATMOSPHERE_RADIUS = 1.6f;
+
+    /** The length of the sun rays the optical depth is integrated along, the shaders read it baked into the LUT. */
+    static constexpr float SUN_RAY_LENGTH = 1.0f;
+
+    /** The name of the instruction set used by @link trace_batch, i.e., "AVX2", "SSE2", or "scalar". */
+    static const char* const INSTRUCTION_SET;
+
+    // ----------------------------------------------------------------------------
+    // Nested Types
+    // ----------------------------------------------------------------------------
+public:
+    /** The distances along a ray where it enters and leaves a sphere. */
+    struct Intersections {
+        float t1;
+        float t2;
+        bool did;
+    };
+
+    // ----------------------------------------------------------------------------
+    // Variables
+    // ----------------------------------------------------------------------------
+private:
+    /** The parameters of the atmosphere. */
+    AtmosphereParameters parameters;
+
+    /** The normalized direction from the center of the earth to the sun. */
+    glm::vec3 dir_to_sun;
+
+    /** The scattering coefficients of the red, green, and blue light. */
+    glm::vec3 scatter_color;
+
+    // ----------------------------------------------------------------------------
+    // Constructors & Destructors
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Constructs a new @link AtmosphereModel.
+     *
+     * @param 	parameters  	The parameters of the atmosphere.
+     * @param 	sun_position	The position of the sun, i.e., of the light in the space scene.
+     */
+    AtmosphereModel(const AtmosphereParameters& parameters, glm::vec3 sun_position);
+
+    // ----------------------------------------------------------------------------
+    // Methods
+    // ----------------------------------------------------------------------------
+public:
+    /** Intersects the ray with the sphere, the intersections behind the origin are ignored as in the shader. */
+    static Intersections sphere_intersection(glm::vec3 sphere_position, float sphere_radius, glm::vec3 position,
+                                             glm::vec3 direction_normal);
+
+    /** Returns the density of the atmosphere at the specified point. */
+    float density_at_point(glm::vec3 position) const;
+
+    /**
+     * Integrates the density along the specified ray using @link AtmosphereParameters::number_of_optical_depths
+     * samples, the first and the last one at the ends of the ray.
+     *
+     * @param 	position	The origin of the ray.
+     * @param 	direction	The normalized direction of the ray.
+     * @param 	length   	The length of the ray.
+     * @return	The optical depth of the ray.
+     */
+    float optical_depth(glm::vec3 position, glm::vec3 direction, float length) const;
+
+    /**
+     * Raymarches the scattered light along the specified part of a view ray.
+     *
+     * @param 	position              	The point where the ray enters the atmosphere.
+     * @param 	direction_normal      	The normalized direction of the ray.
+     * @param 	length                	The length of the ray inside the atmosphere.
+     * @param 	number_of_measurements	The number of measurements along the ray.
+     * @return	The scattered light and the transmittance of the original color in alpha.
+     */
+    glm::vec4 calculate_light(glm::vec3 position, glm::vec3 direction_normal, float length,
+                              int number_of_measurements) const;
+
+    /**
+     * Traces a single view ray through the atmosphere, it is the reference for @link trace_batch.
+     *
+     * @param 	position              	The position of the camera.
+     * @param 	direction_normal      	The normalized direction of the ray.
+     * @param 	number_of_measurements	The number of measurements along the ray.
+     * @return	The scattered light and the transmittance of the original color in alpha, (0, 0, 0, 1) if the ray
+     * 			misses the atmosphere.
+     */
+    glm::vec4 trace(glm::vec3 position, glm::vec3 direction_normal, int number_of_measurements) const;
+
+    /**
+     * Traces @link RayBatch::SIZE view rays at once, the results match @link trace up to the rounding of the
+     * approximated exponential.
+     *
+     * @param 	rays                  	The rays to trace.
+     * @param 	number_of_measurements	The number of measurements along the rays.
+     * @param 	light                 	The scattered light and the transmittances of the rays.
+     */
+    void trace_batch(const RayBatch& rays, int number_of_measurements, LightBatch& light) const;
+
+    /**
+     * Renders the scattering as seen by the camera of the space scene, the rays are generated exactly like by get_ray
+     * in shaders/include/atmosphere.glsl and traced in batches on all hardware threads.
+     *
+     * @param 	width                 	The width of the image.
+     * @param 	height                	The height of the image.
+     * @param 	projection            	The projection matrix of the camera.
+     * @param 	view                  	The view matrix of the camera.
+     * @param 	number_of_measurements	The number of measurements along the rays.
+     * @return	The scattered light and the transmittance of the original color of the pixels (RGBA), the rows go
+     * 			from the bottom of the image as in OpenGL.
+     */
+    std::vector<float> render(int width, int height, const glm::mat4& projection, const glm::mat4& view,
+                              int number_of_measurements) const;
+};
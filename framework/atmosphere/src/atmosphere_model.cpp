@@ -0,0 +1,452 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "atmosphere_model.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+
+#if defined(__AVX2__)
+#define ATMOSPHERE_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ATMOSPHERE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+    // ----------------------------------------------------------------------------
+    // Native Registers
+    // ----------------------------------------------------------------------------
+
+    // The operations on a single register of the instruction set, the masks are registers with all bits of the
+    // selected lanes set. The scalar fallback uses a single float as the register.
+#if defined(ATMOSPHERE_AVX2)
+    using Native = __m256;
+
+    Native broadcast(float value) { return _mm256_set1_ps(value); }
+    Native load(const float* values) { return _mm256_load_ps(values); }
+    void store(float* values, Native value) { _mm256_store_ps(values, value); }
+    Native add(Native a, Native b) { return _mm256_add_ps(a, b); }
+    Native sub(Native a, Native b) { return _mm256_sub_ps(a, b); }
+    Native mul(Native a, Native b) { return _mm256_mul_ps(a, b); }
+    Native div(Native a, Native b) { return _mm256_div_ps(a, b); }
+    Native min(Native a, Native b) { return _mm256_min_ps(a, b); }
+    Native max(Native a, Native b) { return _mm256_max_ps(a, b); }
+    Native sqrt(Native a) { return _mm256_sqrt_ps(a); }
+    Native less(Native a, Native b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    Native less_equal(Native a, Native b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    Native mask_and(Native a, Native b) { return _mm256_and_ps(a, b); }
+    Native select(Native mask, Native a, Native b) { return _mm256_blendv_ps(b, a, mask); }
+    Native round(Native a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+
+    /** Returns 2^n for the integral n in the range of the normalized floats. */
+    Native exp2_integral(Native n) {
+        const __m256i exponent = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(exponent, 23));
+    }
+#elif defined(ATMOSPHERE_SSE2)
+    using Native = __m128;
+
+    Native broadcast(float value) { return _mm_set1_ps(value); }
+    Native load(const float* values) { return _mm_load_ps(values); }
+    void store(float* values, Native value) { _mm_store_ps(values, value); }
+    Native add(Native a, Native b) { return _mm_add_ps(a, b); }
+    Native sub(Native a, Native b) { return _mm_sub_ps(a, b); }
+    Native mul(Native a, Native b) { return _mm_mul_ps(a, b); }
+    Native div(Native a, Native b) { return _mm_div_ps(a, b); }
+    Native min(Native a, Native b) { return _mm_min_ps(a, b); }
+    Native max(Native a, Native b) { return _mm_max_ps(a, b); }
+    Native sqrt(Native a) { return _mm_sqrt_ps(a); }
+    Native less(Native a, Native b) { return _mm_cmplt_ps(a, b); }
+    Native less_equal(Native a, Native b) { return _mm_cmple_ps(a, b); }
+    Native mask_and(Native a, Native b) { return _mm_and_ps(a, b); }
+    Native select(Native mask, Native a, Native b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+    Native round(Native a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+
+    /** Returns 2^n for the integral n in the range of the normalized floats. */
+    Native exp2_integral(Native n) {
+        const __m128i exponent = _mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127));
+        return _mm_castsi128_ps(_mm_slli_epi32(exponent, 23));
+    }
+#else
+    using Native = float;
+
+    Native broadcast(float value) { return value; }
+    Native load(const float* values) { return *values; }
+    void store(float* values, Native value) { *values = value; }
+    Native add(Native a, Native b) { return a + b; }
+    Native sub(Native a, Native b) { return a - b; }
+    Native mul(Native a, Native b) { return a * b; }
+    Native div(Native a, Native b) { return a / b; }
+    Native min(Native a, Native b) { return std::min(a, b); }
+    Native max(Native a, Native b) { return std::max(a, b); }
+    Native sqrt(Native a) { return std::sqrt(a); }
+    Native mask(bool value) { return std::bit_cast<float>(value ? ~uint32_t{0} : uint32_t{0}); }
+    bool is_set(Native mask) { return std::bit_cast<uint32_t>(mask) != 0; }
+    Native less(Native a, Native b) { return mask(a < b); }
+    Native less_equal(Native a, Native b) { return mask(a <= b); }
+    Native mask_and(Native a, Native b) { return mask(is_set(a) && is_set(b)); }
+    Native select(Native mask, Native a, Native b) { return is_set(mask) ? a : b; }
+#endif
+
+    /** The number of floats in a native register. */
+    constexpr int NATIVE_SIZE = sizeof(Native) / sizeof(float);
+
+#if defined(ATMOSPHERE_AVX2) || defined(ATMOSPHERE_SSE2)
+    /** The exponential with the relative error below 2e-7 (the Cephes polynomial), the inputs are clamped. */
+    Native exp(Native x) {
+        x = min(max(x, broadcast(-87.0f)), broadcast(88.0f));
+
+        // e^x = 2^n * e^r, where r = x - n * ln(2) is in [-ln(2)/2, ln(2)/2]
+        const Native n = round(mul(x, broadcast(1.44269504088896341f)));
+        Native r = sub(x, mul(n, broadcast(0.693359375f)));
+        r = sub(r, mul(n, broadcast(-2.12194440e-4f)));
+
+        Native y = broadcast(1.9875691500e-4f);
+        y = add(mul(y, r), broadcast(1.3981999507e-3f));
+        y = add(mul(y, r), broadcast(8.3334519073e-3f));
+        y = add(mul(y, r), broadcast(4.1665795894e-2f));
+        y = add(mul(y, r), broadcast(1.6666665459e-1f));
+        y = add(mul(y, r), broadcast(5.0000001201e-1f));
+        y = add(add(mul(mul(y, r), r), r), broadcast(1.0f));
+
+        return mul(y, exp2_integral(n));
+    }
+#else
+    Native exp(Native x) { return std::exp(x); }
+#endif
+
+    // ----------------------------------------------------------------------------
+    // Lanes
+    // ----------------------------------------------------------------------------
+
+    /** The values of all rays of a batch, stored in as many native registers as needed. */
+    struct Lanes {
+        static const int COUNT = RayBatch::SIZE / NATIVE_SIZE;
+
+        Native registers[COUNT];
+
+        Lanes() = default;
+        Lanes(float value) { std::fill_n(registers, COUNT, broadcast(value)); }
+
+        static Lanes load(const float* values) {
+            Lanes lanes;
+            for (int i = 0; i < COUNT; i++)
+                lanes.registers[i] = ::load(values + i * NATIVE_SIZE);
+            return lanes;
+        }
+
+        void store(float* values) const {
+            for (int i = 0; i < COUNT; i++)
+                ::store(values + i * NATIVE_SIZE, registers[i]);
+        }
+
+        /** Applies the specified operation on the registers of the lanes. */
+        template <typename Operation, typename... Arguments>
+        static Lanes apply(Operation operation, const Arguments&... arguments) {
+            Lanes lanes;
+            for (int i = 0; i < COUNT; i++)
+                lanes.registers[i] = operation(arguments.registers[i]...);
+            return lanes;
+        }
+    };
+
+    /** Applies the specified native operation on the registers of the lanes. */
+    template <Native (*operation)(Native, Native)>
+    Lanes apply(const Lanes& a, const Lanes& b) {
+        return Lanes::apply(operation, a, b);
+    }
+
+    Lanes operator+(const Lanes& a, const Lanes& b) { return apply<add>(a, b); }
+    Lanes operator-(const Lanes& a, const Lanes& b) { return apply<sub>(a, b); }
+    Lanes operator*(const Lanes& a, const Lanes& b) { return apply<mul>(a, b); }
+    Lanes operator/(const Lanes& a, const Lanes& b) { return apply<div>(a, b); }
+    Lanes operator<(const Lanes& a, const Lanes& b) { return apply<less>(a, b); }
+    Lanes operator<=(const Lanes& a, const Lanes& b) { return apply<less_equal>(a, b); }
+    Lanes operator&&(const Lanes& a, const Lanes& b) { return apply<mask_and>(a, b); }
+    Lanes max(const Lanes& a, const Lanes& b) { return apply<max>(a, b); }
+    Lanes& operator+=(Lanes& a, const Lanes& b) { return a = a + b; }
+    Lanes sqrt(const Lanes& a) { return Lanes::apply(static_cast<Native (*)(Native)>(sqrt), a); }
+    Lanes exp(const Lanes& a) { return Lanes::apply(static_cast<Native (*)(Native)>(exp), a); }
+    Lanes select(const Lanes& mask, const Lanes& a, const Lanes& b) {
+        return Lanes::apply(static_cast<Native (*)(Native, Native, Native)>(select), mask, a, b);
+    }
+
+    /** The vectors of all rays of a batch. */
+    struct Vectors {
+        Lanes x, y, z;
+
+        Vectors() = default;
+        Vectors(const Lanes& x, const Lanes& y, const Lanes& z) : x(x), y(y), z(z) {}
+        Vectors(glm::vec3 value) : x(value.x), y(value.y), z(value.z) {}
+    };
+
+    Vectors operator+(const Vectors& a, const Vectors& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+    Vectors operator-(const Vectors& a, const Vectors& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+    Vectors operator*(const Vectors& a, const Lanes& b) { return {a.x * b, a.y * b, a.z * b}; }
+    Lanes dot(const Vectors& a, const Vectors& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    Lanes length(const Vectors& a) { return sqrt(dot(a, a)); }
+
+    /** The intersections of all rays of a batch, the distances of the rays missing the sphere are zero. */
+    struct LanesIntersections {
+        Lanes t1, t2, did;
+    };
+
+    LanesIntersections sphere_intersection(glm::vec3 sphere_position, float sphere_radius, const Vectors& position,
+                                           const Vectors& direction_normal) {
+        const Lanes t = dot(Vectors(sphere_position) - position, direction_normal);
+
+        const Vectors sphere_intersection_midpoint = position + direction_normal * t;
+        const Lanes distance_to_sphere_mid = length(sphere_intersection_midpoint - Vectors(sphere_position));
+
+        const Lanes radius(sphere_radius);
+        const Lanes half_intersect_length =
+            sqrt(max(radius * radius - distance_to_sphere_mid * distance_to_sphere_mid, Lanes(0.0f)));
+        const Lanes t1 = t - half_intersect_length;
+        const Lanes t2 = t + half_intersect_length;
+
+        // The ray hits the sphere if it passes close enough and the sphere is not entirely behind it
+        const Lanes did = distance_to_sphere_mid < radius && Lanes(0.0f) <= t2;
+        return {select(did, t1, Lanes(0.0f)), select(did, t2, Lanes(0.0f)), did};
+    }
+} // namespace
+
+// ----------------------------------------------------------------------------
+// Static Variables
+// ----------------------------------------------------------------------------
+
+#if defined(ATMOSPHERE_AVX2)
+const char* const AtmosphereModel::INSTRUCTION_SET = "AVX2";
+#elif defined(ATMOSPHERE_SSE2)
+const char* const AtmosphereModel::INSTRUCTION_SET = "SSE2";
+#else
+const char* const AtmosphereModel::INSTRUCTION_SET = "scalar";
+#endif
+
+// ----------------------------------------------------------------------------
+// Constructors & Destructors
+// ----------------------------------------------------------------------------
+
+AtmosphereModel::AtmosphereModel(const AtmosphereParameters& parameters, glm::vec3 sun_position)
+    : parameters(parameters), dir_to_sun(glm::normalize(sun_position - EARTH_POSITION)),
+      scatter_color(glm::pow(400.0f / parameters.wave_lengths, glm::vec3(4.0f)) * parameters.scattering_strength) {}
+
+// ----------------------------------------------------------------------------
+// Methods
+// ----------------------------------------------------------------------------
+
+AtmosphereModel::Intersections AtmosphereModel::sphere_intersection(glm::vec3 sphere_position, float sphere_radius,
+                                                                    glm::vec3 position, glm::vec3 direction_normal) {
+    const float t = glm::dot(sphere_position - position, direction_normal);
+
+    const glm::vec3 sphere_intersection_midpoint = position + direction_normal * t;
+    const float distance_to_sphere_mid = glm::length(sphere_intersection_midpoint - sphere_position);
+
+    if (distance_to_sphere_mid < sphere_radius) {
+        const float half_intersect_length =
+            std::sqrt(sphere_radius * sphere_radius - distance_to_sphere_mid * distance_to_sphere_mid);
+        const float t1 = t - half_intersect_length;
+        const float t2 = t + half_intersect_length;
+
+        if (t1 < 0.0f && t2 < 0.0f) {
+            return {0.0f, 0.0f, false};
+        }
+
+        return {t1, t2, true};
+    }
+
+    return {0.0f, 0.0f, false};
+}
+
+float AtmosphereModel::density_at_point(glm::vec3 position) const {
+    const float height_above_surface = glm::length(position - EARTH_POSITION) - EARTH_RADIUS;
+    const float height_scaled = height_above_surface / (ATMOSPHERE_RADIUS - EARTH_RADIUS);
+    return std::exp(-height_scaled * parameters.density_falloff) * (1.0f - height_scaled);
+}
+
+float AtmosphereModel::optical_depth(glm::vec3 position, glm::vec3 direction, float length) const {
+    // A single sample covers the whole ray (the shader divided by zero in that case).
+    const int samples = std::max(1, parameters.number_of_optical_depths);
+    const float step_size = length / float(std::max(1, samples - 1));
+
+    float value = 0.0f;
+    for (int i = 0; i < samples; i++) {
+        value += density_at_point(position + direction * (step_size * float(i))) * step_size;
+    }
+    return value;
+}
+
+glm::vec4 AtmosphereModel::calculate_light(glm::vec3 position, glm::vec3 direction_normal, float length,
+                                           int number_of_measurements) const {
+    const float step_size = length / float(std::max(1, number_of_measurements - 1));
+
+    glm::vec3 scattered_light(0.0f);
+    float view_ray_optical_depth = 0.0f;
+    float previous_density = density_at_point(position);
+
+    for (int i = 0; i < number_of_measurements; i++) {
+        const glm::vec3 scatter_point = position + direction_normal * (step_size * float(i));
+        const float local_density = density_at_point(scatter_point);
+
+        // The view ray depth grows by the segment from the previous measurement (trapezoidal rule).
+        if (i > 0) {
+            view_ray_optical_depth += (previous_density + local_density) * 0.5f * step_size;
+        }
+        previous_density = local_density;
+
+        const float sun_ray_optical_depth = optical_depth(scatter_point, dir_to_sun, SUN_RAY_LENGTH);
+        const glm::vec3 transmittance = glm::exp(-(sun_ray_optical_depth + view_ray_optical_depth) * scatter_color);
+
+        scattered_light += local_density * transmittance * scatter_color * step_size;
+    }
+
+    return glm::vec4(scattered_light, std::exp(-view_ray_optical_depth));
+}
+
+glm::vec4 AtmosphereModel::trace(glm::vec3 position, glm::vec3 direction_normal, int number_of_measurements) const {
+    const Intersections earth_intersections =
+        sphere_intersection(EARTH_POSITION, EARTH_RADIUS, position, direction_normal);
+    const Intersections atmosphere_intersections =
+        sphere_intersection(EARTH_POSITION, ATMOSPHERE_RADIUS, position, direction_normal);
+
+    if (!atmosphere_intersections.did) {
+        return glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    // The ray starts inside the atmosphere if it enters it behind the camera
+    const float distance_to_atmosphere = std::max(atmosphere_intersections.t1, 0.0f);
+    float distance_through_atmosphere = atmosphere_intersections.t2 - distance_to_atmosphere;
+
+    if (earth_intersections.did) {
+        distance_through_atmosphere = earth_intersections.t1 - distance_to_atmosphere;
+    }
+
+    return calculate_light(position + direction_normal * distance_to_atmosphere, direction_normal,
+                           distance_through_atmosphere, number_of_measurements);
+}
+
+void AtmosphereModel::trace_batch(const RayBatch& rays, int number_of_measurements, LightBatch& light) const {
+    const Vectors position(Lanes::load(rays.origin_x), Lanes::load(rays.origin_y), Lanes::load(rays.origin_z));
+    const Vectors direction_normal(Lanes::load(rays.direction_x), Lanes::load(rays.direction_y),
+                                   Lanes::load(rays.direction_z));
+
+    const LanesIntersections earth_intersections =
+        ::sphere_intersection(EARTH_POSITION, EARTH_RADIUS, position, direction_normal);
+    const LanesIntersections atmosphere_intersections =
+        ::sphere_intersection(EARTH_POSITION, ATMOSPHERE_RADIUS, position, direction_normal);
+
+    // The rays missing the atmosphere are marched along zero length and replaced at the end
+    const Lanes distance_to_atmosphere = max(atmosphere_intersections.t1, Lanes(0.0f));
+    const Lanes distance_through_atmosphere =
+        select(earth_intersections.did, earth_intersections.t1 - distance_to_atmosphere,
+               atmosphere_intersections.t2 - distance_to_atmosphere);
+
+    const Vectors start = position + direction_normal * distance_to_atmosphere;
+    const Lanes step_size = distance_through_atmosphere / Lanes(float(std::max(1, number_of_measurements - 1)));
+
+    const Lanes falloff(parameters.density_falloff);
+    const auto density_at_point = [&falloff](const Vectors& point) {
+        const Lanes height_above_surface = length(point - Vectors(EARTH_POSITION)) - Lanes(EARTH_RADIUS);
+        const Lanes height_scaled = height_above_surface / Lanes(ATMOSPHERE_RADIUS - EARTH_RADIUS);
+        return exp(Lanes(0.0f) - height_scaled * falloff) * (Lanes(1.0f) - height_scaled);
+    };
+
+    const int samples = std::max(1, parameters.number_of_optical_depths);
+    const float sun_step_size = SUN_RAY_LENGTH / float(std::max(1, samples - 1));
+
+    Vectors scattered_light(glm::vec3(0.0f));
+    Lanes view_ray_optical_depth(0.0f);
+    Lanes previous_density = density_at_point(start);
+
+    for (int i = 0; i < number_of_measurements; i++) {
+        const Vectors scatter_point = start + direction_normal * (step_size * Lanes(float(i)));
+        const Lanes local_density = density_at_point(scatter_point);
+
+        if (i > 0) {
+            view_ray_optical_depth += (previous_density + local_density) * Lanes(0.5f) * step_size;
+        }
+        previous_density = local_density;
+
+        Lanes sun_ray_optical_depth(0.0f);
+        for (int j = 0; j < samples; j++) {
+            const Vectors sample_point = scatter_point + Vectors(dir_to_sun * (sun_step_size * float(j)));
+            sun_ray_optical_depth += density_at_point(sample_point) * Lanes(sun_step_size);
+        }
+
+        const Lanes optical_depth = sun_ray_optical_depth + view_ray_optical_depth;
+        const Lanes weight = local_density * step_size;
+        scattered_light.x += weight * Lanes(scatter_color.r) * exp(Lanes(-scatter_color.r) * optical_depth);
+        scattered_light.y += weight * Lanes(scatter_color.g) * exp(Lanes(-scatter_color.g) * optical_depth);
+        scattered_light.z += weight * Lanes(scatter_color.b) * exp(Lanes(-scatter_color.b) * optical_depth);
+    }
+
+    const Lanes& did = atmosphere_intersections.did;
+    select(did, scattered_light.x, Lanes(0.0f)).store(light.red);
+    select(did, scattered_light.y, Lanes(0.0f)).store(light.green);
+    select(did, scattered_light.z, Lanes(0.0f)).store(light.blue);
+    select(did, exp(Lanes(0.0f) - view_ray_optical_depth), Lanes(1.0f)).store(light.transmittance);
+}
+
+std::vector<float> AtmosphereModel::render(int width, int height, const glm::mat4& projection, const glm::mat4& view,
+                                           int number_of_measurements) const {
+    const glm::mat4 inverse_projection = glm::inverse(projection);
+    const glm::mat4 inverse_view = glm::inverse(view);
+    const glm::vec3 camera_position = inverse_view[3];
+
+    std::vector<float> pixels(size_t(width) * height * 4);
+
+    // The rows are taken one by one by the threads, a batch covers consecutive pixels of a row
+    std::atomic<int> next_row = 0;
+    const auto render_rows = [&]() {
+        RayBatch rays;
+        LightBatch light;
+        for (int y = next_row++; y < height; y = next_row++) {
+            for (int x0 = 0; x0 < width; x0 += RayBatch::SIZE) {
+                for (int lane = 0; lane < RayBatch::SIZE; lane++) {
+                    // The pixels past the end of the row repeat the last one
+                    const int x = std::min(x0 + lane, width - 1);
+
+                    // The same ray as get_ray in include/atmosphere.glsl
+                    const glm::vec2 uv = (glm::vec2(x, y) + 0.5f) / glm::vec2(width, height);
+                    const glm::vec4 ray_eye = inverse_projection * glm::vec4((uv - 0.5f) * 2.0f, -1.0f, 1.0f);
+                    const glm::vec3 direction =
+                        glm::normalize(glm::vec3(inverse_view * glm::vec4(ray_eye.x, ray_eye.y, -1.0f, 0.0f)));
+
+                    rays.origin_x[lane] = camera_position.x;
+                    rays.origin_y[lane] = camera_position.y;
+                    rays.origin_z[lane] = camera_position.z;
+                    rays.direction_x[lane] = direction.x;
+                    rays.direction_y[lane] = direction.y;
+                    rays.direction_z[lane] = direction.z;
+                }
+
+                trace_batch(rays, number_of_measurements, light);
+
+                for (int lane = 0; lane < RayBatch::SIZE && x0 + lane < width; lane++) {
+                    float* pixel = pixels.data() + (size_t(y) * width + x0 + lane) * 4;
+                    pixel[0] = light.red[lane];
+                    pixel[1] = light.green[lane];
+                    pixel[2] = light.blue[lane];
+                    pixel[3] = light.transmittance[lane];
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> threads(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    for (auto& thread : threads)
+        thread = std::thread(render_rows);
+    render_rows();
+    for (auto& thread : threads)
+        thread.join();
+
+    return pixels;
+}
@@ -0,0 +1,80 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "atmosphere_model.hpp"
+#include <benchmark/benchmark.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+    const AtmosphereParameters parameters{4.3f, 8.0f, glm::vec3(700.0f, 530.0f, 440.0f), 10};
+    const glm::vec3 sun_position(10.0f, 10.0f, -10.0f);
+
+    /** Fills the batch with the rays from above the atmosphere towards the limb of the planet. */
+    RayBatch limb_rays() {
+        RayBatch rays;
+        for (int lane = 0; lane < RayBatch::SIZE; lane++) {
+            const glm::vec3 direction = glm::normalize(glm::vec3(1.1f + 0.05f * float(lane), 0.2f, -4.0f));
+            rays.origin_x[lane] = 0.0f;
+            rays.origin_y[lane] = 0.0f;
+            rays.origin_z[lane] = 5.0f;
+            rays.direction_x[lane] = direction.x;
+            rays.direction_y[lane] = direction.y;
+            rays.direction_z[lane] = direction.z;
+        }
+        return rays;
+    }
+} // namespace
+
+/** Traces the rays one by one, the argument is the number of measurements. */
+static void BM_Trace(benchmark::State& state) {
+    const AtmosphereModel model(parameters, sun_position);
+    const RayBatch rays = limb_rays();
+    const int number_of_measurements = int(state.range(0));
+
+    for (auto _ : state) {
+        for (int lane = 0; lane < RayBatch::SIZE; lane++) {
+            const glm::vec3 origin(rays.origin_x[lane], rays.origin_y[lane], rays.origin_z[lane]);
+            const glm::vec3 direction(rays.direction_x[lane], rays.direction_y[lane], rays.direction_z[lane]);
+            benchmark::DoNotOptimize(model.trace(origin, direction, number_of_measurements));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * RayBatch::SIZE);
+    state.SetLabel("rays");
+}
+BENCHMARK(BM_Trace)->Arg(10)->Arg(20);
+
+/** Traces the rays in batches, the argument is the number of measurements. */
+static void BM_TraceBatch(benchmark::State& state) {
+    const AtmosphereModel model(parameters, sun_position);
+    const RayBatch rays = limb_rays();
+    const int number_of_measurements = int(state.range(0));
+    LightBatch light;
+
+    for (auto _ : state) {
+        model.trace_batch(rays, number_of_measurements, light);
+        benchmark::DoNotOptimize(light);
+    }
+    state.SetItemsProcessed(state.iterations() * RayBatch::SIZE);
+    state.SetLabel(AtmosphereModel::INSTRUCTION_SET);
+}
+BENCHMARK(BM_TraceBatch)->Arg(10)->Arg(20);
+
+/** Renders a whole 256x256 thumbnail on all threads. */
+static void BM_Render(benchmark::State& state) {
+    const AtmosphereModel model(parameters, sun_position);
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.01f, 1000.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 5.0f), AtmosphereModel::EARTH_POSITION,
+                                       glm::vec3(0.0f, 1.0f, 0.0f));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(model.render(256, 256, projection, view, 10));
+    }
+    state.SetItemsProcessed(state.iterations() * 256 * 256);
+}
+BENCHMARK(BM_Render)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,69 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "atmosphere_model.hpp"
+#include <algorithm>
+#include <chrono>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <string>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+/**
+ * Renders the atmosphere of PlanetGL on the CPU and writes it into a PNG file, the planet and the space behind are
+ * black.
+ *
+ * Usage: atmosphere_thumbnail <output.png> [width] [height] [measurements] [camera distance]
+ */
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <output.png> [width] [height] [measurements] [camera distance]"
+                  << std::endl;
+        return 1;
+    }
+
+    const int width = argc > 2 ? std::stoi(argv[2]) : 256;
+    const int height = argc > 3 ? std::stoi(argv[3]) : 256;
+    const int number_of_measurements = argc > 4 ? std::stoi(argv[4]) : 10;
+    const float camera_distance = argc > 5 ? std::stof(argv[5]) : 4.0f;
+
+    // The default parameters and the light of the space scene
+    const AtmosphereParameters parameters{4.3f, 8.0f, glm::vec3(700.0f, 530.0f, 440.0f), 10};
+    const AtmosphereModel model(parameters, glm::vec3(10.0f, 10.0f, -10.0f));
+
+    const glm::vec3 eye = AtmosphereModel::EARTH_POSITION + glm::vec3(0.0f, 0.0f, camera_distance);
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f), float(width) / float(height), 0.01f, 1000.0f);
+    const glm::mat4 view = glm::lookAt(eye, AtmosphereModel::EARTH_POSITION, glm::vec3(0.0f, 1.0f, 0.0f));
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<float> light = model.render(width, height, projection, view, number_of_measurements);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // The image rows go from the top
+    std::vector<unsigned char> pixels(size_t(width) * height * 3);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const float* source = light.data() + (size_t(height - 1 - y) * width + x) * 4;
+            unsigned char* target = pixels.data() + (size_t(y) * width + x) * 3;
+            for (int c = 0; c < 3; c++) {
+                target[c] = static_cast<unsigned char>(std::clamp(source[c], 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+        }
+    }
+
+    if (!stbi_write_png(argv[1], width, height, 3, pixels.data(), width * 3)) {
+        std::cerr << "Failed to write " << argv[1] << "." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Rendered " << width << "x" << height << " in " << seconds * 1000.0 << " ms ("
+              << double(width) * height / seconds / 1e6 << " Mrays/s, " << AtmosphereModel::INSTRUCTION_SET << ")"
+              << std::endl;
+    return 0;
+}
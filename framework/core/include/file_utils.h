@@ -0,0 +1,47 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <ostream>
+
+/**
+ * The class providing static utility methods shared by the on-disk caches of the framework (meshes, textures, shader
+ * programs), i.e., hashing their sources and writing the cache files safely.
+ */
+class FileUtils {
+public:
+    /** The initial value of the 64-bit FNV-1a hash. */
+    static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+
+    /**
+     * Continues the 64-bit FNV-1a hash with the specified bytes.
+     *
+     * @param 	hash	The hash of the preceding bytes ({@link FNV_OFFSET_BASIS} for the first ones).
+     * @param 	data	The bytes to hash.
+     * @param 	size	The number of bytes.
+     * @return	The updated hash.
+     */
+    static uint64_t hash_bytes(uint64_t hash, const void* data, size_t size);
+
+    /** Computes the 64-bit FNV-1a hash of the content of the specified file (an unreadable file hashes as empty). */
+    static uint64_t hash_file(const std::filesystem::path& path);
+
+    /**
+     * Writes a file into a temporary file first and replaces the target only once everything was written, so an
+     * interrupted write never leaves a broken file behind. Failures are reported to the standard error output.
+     *
+     * @param 	path 	The path to the written file.
+     * @param 	write	The function writing the content of the file into the stream.
+     * @return	True if the file was written successfully.
+     */
+    static bool write_atomically(const std::filesystem::path& path, const std::function<void(std::ostream&)>& write);
+};
@@ -0,0 +1,98 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+/**
+ * The unbounded lock-free queue with multiple producers and a single consumer (the node-based queue by Dmitry Vyukov).
+ * <p>
+ * Any thread may call {@link push}, but only one thread at a time may call {@link pop}. A push never blocks and a pop
+ * never waits for a producer, it only returns nothing if the next element is not completely published yet.
+ */
+template <typename T> class MpscQueue {
+
+    // ----------------------------------------------------------------------------
+    // Nested Types
+    // ----------------------------------------------------------------------------
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        std::optional<T> value;
+    };
+
+    // ----------------------------------------------------------------------------
+    // Variables
+    // ----------------------------------------------------------------------------
+private:
+    /** The most recently pushed node, shared by the producers. */
+    std::atomic<Node*> head;
+
+    /** The node preceding the oldest element, owned by the consumer. Its value has already been consumed. */
+    Node* tail;
+
+    // ----------------------------------------------------------------------------
+    // Constructors & Destructors
+    // ----------------------------------------------------------------------------
+public:
+    MpscQueue() {
+        Node* stub = new Node();
+        head.store(stub, std::memory_order_relaxed);
+        tail = stub;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    /** Destroys the queue together with all elements that were not popped. */
+    ~MpscQueue() {
+        while (tail) {
+            Node* next = tail->next.load(std::memory_order_relaxed);
+            delete tail;
+            tail = next;
+        }
+    }
+
+    // ----------------------------------------------------------------------------
+    // Methods
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Appends the value to the end of the queue. Can be called from any thread.
+     *
+     * @param 	value	The value to append.
+     */
+    void push(T value) {
+        Node* node = new Node();
+        node->value.emplace(std::move(value));
+
+        Node* previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    /**
+     * Removes the oldest value from the queue. Must be called only from the consumer thread.
+     *
+     * @return	The removed value, or nothing if the queue is empty.
+     */
+    std::optional<T> pop() {
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) {
+            return std::nullopt;
+        }
+
+        // The popped node becomes the new stub.
+        std::optional<T> value = std::move(next->value);
+        next->value.reset();
+        delete tail;
+        tail = next;
+        return value;
+    }
+};
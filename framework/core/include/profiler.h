@@ -0,0 +1,210 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include "glad/glad.h"
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+/**
+ * The frame profiler measuring the CPU and GPU time of named scopes, see {@link PROFILE_SCOPE}.
+ * <p>
+ * The CPU time is measured with the steady clock. The GPU time is measured with timestamp queries, which (unlike
+ * GL_TIME_ELAPSED queries) may nest. The queries of a frame are read {@link QUERY_LATENCY} frames later, when the GPU
+ * has finished them, so the frames enter the history with that delay and reading them never stalls the pipeline.
+ * <p>
+ * The profiler is driven by {@link ApplicationManager::run}, which makes it active for the render loop and wraps the
+ * application callbacks into scopes. The scopes opened outside of a frame are ignored.
+ */
+class Profiler {
+
+    // ----------------------------------------------------------------------------
+    // Static Variables
+    // ----------------------------------------------------------------------------
+public:
+    /** The number of frames kept in the history. */
+    static constexpr size_t FRAME_HISTORY = 240;
+
+    /** The number of frames the GPU timestamps are read after. */
+    static constexpr size_t QUERY_LATENCY = 3;
+
+private:
+    /** The profiler the scopes are recorded to, null if there is none. */
+    static Profiler* active_profiler;
+
+    // ----------------------------------------------------------------------------
+    // Nested Types
+    // ----------------------------------------------------------------------------
+public:
+    /** A single measured scope, the times are in milliseconds relative to the beginning of the frame. */
+    struct Sample {
+        /** The name of the scope, it must outlive the profiler (i.e., it is a string literal). */
+        const char* name;
+        /** The nesting level, 0 is the whole frame. */
+        int depth;
+        double cpu_start;
+        double cpu_time;
+        double gpu_start;
+        double gpu_time;
+    };
+
+    /** The samples of a frame in the order the scopes were opened, the first one is the whole frame. */
+    struct Frame {
+        size_t index = 0;
+        std::vector<Sample> samples;
+    };
+
+private:
+    /** A frame waiting for its timestamp queries, the sample i uses the queries 2i and 2i + 1. */
+    struct PendingFrame {
+        Frame frame;
+        std::vector<GLuint> queries;
+        bool pending = false;
+    };
+
+    // ----------------------------------------------------------------------------
+    // Variables
+    // ----------------------------------------------------------------------------
+private:
+    /** The frames whose timestamps are not read yet, indexed by the frame index modulo {@link QUERY_LATENCY}. */
+    std::array<PendingFrame, QUERY_LATENCY> pending_frames;
+
+    /** The ring buffer of the finished frames, {@link history_start} is the oldest one. */
+    std::vector<Frame> history;
+    size_t history_start = 0;
+
+    /** The index of the current frame. */
+    size_t frame_index = 0;
+
+    /** The flag determining if a frame is being recorded. */
+    bool in_frame = false;
+
+    /** The nesting level of the next scope. */
+    int depth = 0;
+
+    /** The CPU time the current frame began at. */
+    std::chrono::steady_clock::time_point frame_start;
+
+    // ----------------------------------------------------------------------------
+    // Constructors & Destructors
+    // ----------------------------------------------------------------------------
+public:
+    /** Constructs a new {@link Profiler}, the queries are created lazily when the first frame begins. */
+    Profiler() = default;
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    /** Deletes the queries, the OpenGL context must still be current. */
+    ~Profiler();
+
+    // ----------------------------------------------------------------------------
+    // Methods
+    // ----------------------------------------------------------------------------
+public:
+    /** Returns the profiler the scopes are recorded to, null if there is none. */
+    static Profiler* get_active();
+
+    /** Sets the profiler the scopes are recorded to, null disables the recording. */
+    static void set_active(Profiler* profiler);
+
+    /** Begins a new frame and moves the frame whose timestamps are finished into the history. */
+    void begin_frame();
+
+    /** Ends the current frame, all of its scopes must be closed. */
+    void end_frame();
+
+    /**
+     * Opens a new scope nested in the currently open ones.
+     *
+     * @param 	name	The name of the scope, it must outlive the profiler (i.e., a string literal).
+     * @return	The index of the sample to pass to {@link end_scope}, or -1 if no frame is being recorded.
+     */
+    int begin_scope(const char* name);
+
+    /**
+     * Closes the scope opened by {@link begin_scope}.
+     *
+     * @param 	sample	The index returned by {@link begin_scope}.
+     */
+    void end_scope(int sample);
+
+    /** Returns the number of the frames in the history. */
+    size_t get_frame_count() const;
+
+    /**
+     * Returns a frame from the history.
+     *
+     * @param 	age	The age of the frame, 0 is the most recent finished frame.
+     */
+    const Frame& get_frame(size_t age) const;
+
+    /** Returns the total GPU time of the scopes with the specified name in the most recent finished frame. */
+    double get_gpu_time(std::string_view name) const;
+
+    /**
+     * Writes the history into a CSV file with a row per sample.
+     *
+     * @param 	path	The path of the file.
+     * @return	True if the file was written.
+     */
+    bool export_csv(const std::filesystem::path& path) const;
+
+private:
+    /** Reads the timestamps of the pending frame and moves it into the history. */
+    void resolve(PendingFrame& pending);
+};
+
+/** The RAII guard measuring a scope of the active {@link Profiler}, see {@link PROFILE_SCOPE}. */
+class ProfileScope {
+
+    // ----------------------------------------------------------------------------
+    // Variables
+    // ----------------------------------------------------------------------------
+private:
+    Profiler* profiler;
+    int sample;
+
+    // ----------------------------------------------------------------------------
+    // Constructors & Destructors
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Opens a new scope of the active profiler, if any.
+     *
+     * @param 	name	The name of the scope, it must outlive the profiler (i.e., a string literal).
+     */
+    explicit ProfileScope(const char* name)
+        : profiler(Profiler::get_active()), sample(profiler ? profiler->begin_scope(name) : -1) {}
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    /** Closes the scope unless it was closed by {@link end}. */
+    ~ProfileScope() { end(); }
+
+    // ----------------------------------------------------------------------------
+    // Methods
+    // ----------------------------------------------------------------------------
+public:
+    /** Closes the scope before the end of the enclosing block. */
+    void end() {
+        if (sample >= 0)
+            profiler->end_scope(sample);
+        sample = -1;
+    }
+};
+
+#define PROFILE_SCOPE_CONCAT_INNER(a, b) a##b
+#define PROFILE_SCOPE_CONCAT(a, b) PROFILE_SCOPE_CONCAT_INNER(a, b)
+
+/** Measures the CPU and GPU time from this line to the end of the enclosing block. */
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_SCOPE_CONCAT(profile_scope_, __LINE__)(name)
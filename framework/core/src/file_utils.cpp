@@ -0,0 +1,68 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "file_utils.h"
+#include <fstream>
+#include <iostream>
+#include <system_error>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Methods
+// ----------------------------------------------------------------------------
+
+uint64_t FileUtils::hash_bytes(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t FileUtils::hash_file(const std::filesystem::path& path) {
+    std::ifstream input{path, std::ios::binary};
+
+    uint64_t hash = FNV_OFFSET_BASIS;
+    std::vector<char> buffer(64 * 1024);
+    while (input.read(buffer.data(), std::streamsize(buffer.size())) || input.gcount() > 0) {
+        hash = hash_bytes(hash, buffer.data(), size_t(input.gcount()));
+    }
+    return hash;
+}
+
+bool FileUtils::write_atomically(const std::filesystem::path& path, const std::function<void(std::ostream&)>& write) {
+    std::filesystem::path temporary_path = path;
+    temporary_path += ".tmp";
+
+    std::error_code error;
+    {
+        std::ofstream output{temporary_path, std::ios::binary | std::ios::trunc};
+        if (!output.is_open()) {
+            std::cerr << "Could not write " << path.generic_string() << std::endl;
+            return false;
+        }
+
+        write(output);
+
+        if (!output.good()) {
+            std::cerr << "Could not write " << path.generic_string() << std::endl;
+            output.close();
+            std::filesystem::remove(temporary_path, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporary_path, path, error);
+    if (error) {
+        std::cerr << "Could not write " << path.generic_string() << ": " << error.message() << std::endl;
+        std::filesystem::remove(temporary_path, error);
+        return false;
+    }
+
+    return true;
+}
@@ -8,6 +8,7 @@
 #include "manager.h"
 #include "GLFW/glfw3.h"
 #include "glad/glad.h"
+#include "profiler.h"
 #include <iostream>
 #include <ostream>
 
@@ -100,7 +101,13 @@ void ApplicationManager::run(IApplication& application) {
     // Runs the extension hook.
     this->pre_render_loop(application);
 
+    // The profiler lives only while the context is current, it deletes its queries when the loop ends.
+    Profiler profiler;
+    Profiler::set_active(&profiler);
+
     while (!glfwWindowShouldClose(window)) {
+        profiler.begin_frame();
+
         // Measures the elapsed time.
         const double current_time = glfwGetTime() * 1000.0; // from seconds to milliseconds
         const double elapsed_time = current_time - last_glfw_time;
@@ -113,16 +120,32 @@ void ApplicationManager::run(IApplication& application) {
         this->pre_frame_render();
 
         // Application render
-        application.update(static_cast<float>(elapsed_time));
-        application.render();
-        application.render_ui();
+        {
+            PROFILE_SCOPE("update");
+            application.update(static_cast<float>(elapsed_time));
+        }
+        {
+            PROFILE_SCOPE("render");
+            application.render();
+        }
+        {
+            PROFILE_SCOPE("render_ui");
+            application.render_ui();
+        }
 
         // Rendering
-        this->post_frame_render();
+        {
+            PROFILE_SCOPE("post_frame_render");
+            this->post_frame_render();
+        }
+
+        profiler.end_frame();
 
         // Swap front and back buffers
         glfwSwapBuffers(window);
     }
+
+    Profiler::set_active(nullptr);
 }
 
 void ApplicationManager::terminate() {
@@ -0,0 +1,147 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "profiler.h"
+#include <fstream>
+
+Profiler* Profiler::active_profiler = nullptr;
+
+// ----------------------------------------------------------------------------
+// Constructors & Destructors
+// ----------------------------------------------------------------------------
+Profiler::~Profiler() {
+    if (active_profiler == this)
+        active_profiler = nullptr;
+
+    for (PendingFrame& pending : pending_frames)
+        glDeleteQueries(GLsizei(pending.queries.size()), pending.queries.data());
+}
+
+// ----------------------------------------------------------------------------
+// Methods
+// ----------------------------------------------------------------------------
+Profiler* Profiler::get_active() { return active_profiler; }
+
+void Profiler::set_active(Profiler* profiler) { active_profiler = profiler; }
+
+void Profiler::begin_frame() {
+    PendingFrame& pending = pending_frames[frame_index % QUERY_LATENCY];
+    if (pending.pending)
+        resolve(pending);
+
+    pending.frame.index = frame_index;
+    pending.frame.samples.clear();
+    frame_start = std::chrono::steady_clock::now();
+    in_frame = true;
+    depth = 0;
+
+    begin_scope("frame");
+}
+
+void Profiler::end_frame() {
+    if (!in_frame)
+        return;
+
+    end_scope(0);
+    pending_frames[frame_index % QUERY_LATENCY].pending = true;
+    in_frame = false;
+    frame_index++;
+}
+
+int Profiler::begin_scope(const char* name) {
+    if (!in_frame)
+        return -1;
+
+    PendingFrame& pending = pending_frames[frame_index % QUERY_LATENCY];
+    const size_t sample = pending.frame.samples.size();
+
+    // The query pool only grows, the scopes are mostly the same every frame
+    if (pending.queries.size() < 2 * (sample + 1)) {
+        const size_t old_size = pending.queries.size();
+        pending.queries.resize(2 * (sample + 1));
+        glGenQueries(GLsizei(pending.queries.size() - old_size), pending.queries.data() + old_size);
+    }
+
+    const double cpu_start =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count();
+    pending.frame.samples.push_back({name, depth, cpu_start, 0.0, 0.0, 0.0});
+    glQueryCounter(pending.queries[2 * sample], GL_TIMESTAMP);
+    depth++;
+
+    return int(sample);
+}
+
+void Profiler::end_scope(int sample) {
+    if (!in_frame || sample < 0)
+        return;
+
+    PendingFrame& pending = pending_frames[frame_index % QUERY_LATENCY];
+    glQueryCounter(pending.queries[2 * sample + 1], GL_TIMESTAMP);
+
+    Sample& measured = pending.frame.samples[sample];
+    measured.cpu_time =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count()
+        - measured.cpu_start;
+    depth--;
+}
+
+void Profiler::resolve(PendingFrame& pending) {
+    pending.pending = false;
+    std::vector<Sample>& samples = pending.frame.samples;
+    if (samples.empty())
+        return;
+
+    // The queries are QUERY_LATENCY frames old, so waiting for the results does not stall in practice
+    std::vector<GLuint64> timestamps(2 * samples.size());
+    for (size_t i = 0; i < timestamps.size(); i++)
+        glGetQueryObjectui64v(pending.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+
+    for (size_t i = 0; i < samples.size(); i++) {
+        samples[i].gpu_start = double(timestamps[2 * i] - timestamps[0]) / 1e6;
+        samples[i].gpu_time = double(timestamps[2 * i + 1] - timestamps[2 * i]) / 1e6;
+    }
+
+    if (history.size() < FRAME_HISTORY) {
+        history.push_back(pending.frame);
+    } else {
+        history[history_start] = pending.frame;
+        history_start = (history_start + 1) % FRAME_HISTORY;
+    }
+}
+
+size_t Profiler::get_frame_count() const { return history.size(); }
+
+const Profiler::Frame& Profiler::get_frame(size_t age) const {
+    return history[(history_start + history.size() - 1 - age) % history.size()];
+}
+
+double Profiler::get_gpu_time(std::string_view name) const {
+    if (history.empty())
+        return 0.0;
+
+    double time = 0.0;
+    for (const Sample& sample : get_frame(0).samples)
+        if (sample.name == name)
+            time += sample.gpu_time;
+    return time;
+}
+
+bool Profiler::export_csv(const std::filesystem::path& path) const {
+    std::ofstream file(path);
+    if (!file.is_open())
+        return false;
+
+    file << "frame,scope,depth,cpu_start_ms,cpu_ms,gpu_start_ms,gpu_ms\n";
+    for (size_t age = get_frame_count(); age-- > 0;) {
+        const Frame& frame = get_frame(age);
+        for (const Sample& sample : frame.samples)
+            file << frame.index << ',' << sample.name << ',' << sample.depth << ',' << sample.cpu_start << ','
+                 << sample.cpu_time << ',' << sample.gpu_start << ',' << sample.gpu_time << '\n';
+    }
+
+    return bool(file);
+}
@@ -0,0 +1,116 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include "mip_chain.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+/**
+ * An image compressed into 4x4 blocks together with all its mipmap levels. The levels are stored one after another in
+ * {@link blocks}, in the layout expected by glCompressedTextureSubImage2D.
+ * <p>
+ * Opaque images use BC1 (8 bytes per block, i.e., 0.5 bytes per texel), images with an alpha channel use BC3 (16 bytes
+ * per block, i.e., 1 byte per texel).
+ */
+struct CompressedImage {
+    /** The OpenGL internal format of BC1 (GL_COMPRESSED_RGB_S3TC_DXT1_EXT). */
+    static const uint32_t BC1 = 0x83F0;
+
+    /** The OpenGL internal format of BC3 (GL_COMPRESSED_RGBA_S3TC_DXT5_EXT). */
+    static const uint32_t BC3 = 0x83F3;
+
+    /** The version of the cache format, increase it whenever the layout of the data or the encoder changes. */
+    static const uint32_t VERSION = 1;
+
+    /** The extension appended to the source file name to get the cache file name. */
+    static constexpr const char* EXTENSION = ".bctex";
+
+    /** The placement of a single mipmap level in {@link blocks}. */
+    struct Level {
+        int width;
+        int height;
+        size_t offset;
+        size_t size;
+    };
+
+    /** The OpenGL internal format of the blocks, i.e., {@link BC1} or {@link BC3}. */
+    uint32_t format = 0;
+
+    /** The levels from the largest (the original image) to 1x1. */
+    std::vector<Level> levels;
+
+    /** The compressed blocks of all levels. */
+    std::vector<unsigned char> blocks;
+
+    /** Returns the pointer to the blocks of the specified level. */
+    const unsigned char* data(size_t level) const { return blocks.data() + levels[level].offset; }
+
+    /** Returns the width of the original image. */
+    int width() const { return levels.empty() ? 0 : levels[0].width; }
+
+    /** Returns the height of the original image. */
+    int height() const { return levels.empty() ? 0 : levels[0].height; }
+
+    /**
+     * Returns the path of the cache file corresponding to the specified source image.
+     *
+     * @param 	source_path	The path to the source image.
+     */
+    static std::filesystem::path cache_path(const std::filesystem::path& source_path);
+
+    /**
+     * Reads the compressed image of the specified source image from its cache file.
+     *
+     * @param 	source_path	The path to the source image.
+     * @return	The compressed image, or nothing if the cache does not exist or is out of date.
+     */
+    static std::optional<CompressedImage> load(const std::filesystem::path& source_path);
+
+    /**
+     * Writes the compressed image into the cache file of the specified source image. Failures are reported but
+     * otherwise ignored as the cache is only an optimization.
+     *
+     * @param 	source_path	The path to the source image.
+     * @return	True if the cache was written successfully.
+     */
+    bool store(const std::filesystem::path& source_path) const;
+};
+
+/**
+ * Compresses all levels of the image, choosing BC1 if the image is opaque and BC3 otherwise. The edge blocks of levels
+ * whose size is not a multiple of 4 are padded by repeating the last row and column.
+ *
+ * @param 	image		The image with its mipmap levels.
+ * @param 	high_quality	True to refine the block endpoints more (slower).
+ * @return	The compressed image.
+ */
+CompressedImage compress_image(const MipChain& image, bool high_quality = true);
+
+/**
+ * Decompresses a single level of the compressed image back into RGBA8 pixels.
+ *
+ * @param 	image	The compressed image.
+ * @param 	level	The level to decompress.
+ * @return	The RGBA8 pixels of the level.
+ */
+std::vector<unsigned char> decompress_level(const CompressedImage& image, size_t level);
+
+/**
+ * Computes the peak signal-to-noise ratio of a compressed level against the original pixels. Only the color channels
+ * are compared for BC1, the alpha channel is included for BC3.
+ *
+ * @param 	image	  	The original image.
+ * @param 	compressed	The compressed image.
+ * @param 	level	  	The level to compare.
+ * @return	The PSNR in decibels (infinity if the level is lossless).
+ */
+double compute_psnr(const MipChain& image, const CompressedImage& compressed, size_t level = 0);
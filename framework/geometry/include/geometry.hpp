@@ -9,6 +9,7 @@
 
 #include "geometry_base.hpp"
 #include "glad/glad.h"
+#include "mesh_data.hpp"
 #include <filesystem>
 #include <vector>
 
@@ -47,6 +48,28 @@ public:
              GLint tex_coord_loc = DEFAULT_TEX_COORD_LOC, GLint tangent_loc = DEFAULT_TANGENT_LOC,
              GLint bitangent_loc = DEFAULT_BITANGENT_LOC);
 
+    /**
+     * Creates a @link Geometry object whose indices are stored using the specified type.
+     * @param   mode                The mode that will be used for rendering the geometry.
+     * @param   elements_per_vertex The number of float values stored in the buffer for each vertex.
+     * @param 	vertices_count	    The number of vertices that the created geometry will have.
+     * @param 	vertices	    The actual geometry vertices.
+     * @param 	indices_count 	    The number of indices within the geometry.
+     * @param 	indices		    The actual indices.
+     * @param 	index_type	    The type of the indices, i.e., GL_UNSIGNED_INT or GL_UNSIGNED_SHORT.
+     * @param 	position_loc  	    The location of position vertex attribute for the VAO (use -1 if not necessary).
+     * @param 	normal_loc	    The location of normal vertex attribute for the VAO (use -1 if not necessary).
+     * @param 	tex_coord_loc 	    The location of texture coordinates vertex attribute for the VAO (use -1 if not necessary).
+     * @param 	tangent_loc   	    The location of tangent vertex attribute for the VAO (use -1 if not necessary).
+     * @param 	bitangent_loc 	    The location of bitangent vertex attribute for the VAO (use -1 if not necessary).
+     * @param 	color_loc 	    The location of color vertex attribute for the VAO (use -1 if not necessary).
+     */
+    Geometry(GLenum mode, int elements_per_vertex, int vertices_count, const float* vertices, int indices_count,
+             const void* indices, GLenum index_type, GLint position_loc = DEFAULT_POSITION_LOC,
+             GLint normal_loc = DEFAULT_NORMAL_LOC, GLint tex_coord_loc = DEFAULT_TEX_COORD_LOC,
+             GLint tangent_loc = DEFAULT_TANGENT_LOC, GLint bitangent_loc = DEFAULT_BITANGENT_LOC,
+             GLint color_loc = DEFAULT_COLOR_LOC);
+
     /**
      * Creates a @link Geometry object. TODO add colors
      *
@@ -98,6 +121,15 @@ public:
         GLint tangent_loc = DEFAULT_TANGENT_LOC,
         GLint bitangent_loc = DEFAULT_BITANGENT_LOC);
 
+    /**
+     * Creates a @link Geometry object from an imported mesh. The indices are stored using the smallest type that can
+     * address all vertices.
+     *
+     * @param 	mesh	The imported mesh.
+     * @param 	mode	The mode that will be used for rendering the geometry.
+     */
+    explicit Geometry(const MeshData& mesh, GLenum mode = GL_TRIANGLES);
+
     /**
      * Creates a new @link Geometry object from another geometry performing a deep copy.
      *
@@ -91,6 +91,9 @@ public:
     /** The number of vertices to be drawn using glDrawElements. */
     GLsizei draw_elements_count = 0;
 
+    /** The type of the values stored in {@link index_buffer}, i.e., GL_UNSIGNED_INT or GL_UNSIGNED_SHORT. */
+    GLenum index_type = GL_UNSIGNED_INT;
+
     /** The number of patch vertices. This variable is used only when mode is set to GL_PATCHES, otherwise it is ignored. */
     GLsizei patch_vertices = 0;
 
@@ -179,7 +182,7 @@ public:
         : mode(other.mode), vertex_buffer_size(other.vertex_buffer_size), vertex_buffer_stride(other.vertex_buffer_stride), interleaved_vertices(other.interleaved_vertices),
           position_offset(other.position_offset), color_offset(other.color_offset), normal_offset(other.normal_offset), tex_coord_offset(other.tex_coord_offset),
           elements_per_vertex(other.elements_per_vertex), draw_arrays_count(other.draw_arrays_count),
-          draw_elements_count(other.draw_elements_count), // vao(other.vao), vertex_buffer(other.vertex_buffer), index_buffer(other.index_buffer), THESE SHOULD NOT BE COPIED BUT NEEDS TO BE RECREATED
+          draw_elements_count(other.draw_elements_count), index_type(other.index_type), // vao(other.vao), vertex_buffer(other.vertex_buffer), index_buffer(other.index_buffer), THESE SHOULD NOT BE COPIED BUT NEEDS TO BE RECREATED
           patch_vertices(other.patch_vertices), position_loc(other.position_loc), normal_loc(other.normal_loc), tex_coord_loc(other.tex_coord_loc), tangent_loc(other.tangent_loc),
           bitangent_loc(other.bitangent_loc), color_loc(other.color_loc) {};
 
@@ -226,6 +229,9 @@ public:
     /** Binds the VAO corresponding to this geometry. */
     void bind_vao() const;
 
+    /** Returns the size (in bytes) of a single index stored in {@link index_buffer}. */
+    GLsizei index_size() const;
+
     /**
      * Draws the geometry using either glDrawArrays or glDrawElements based on the current values of {@link draw_arrays_count} and
      * {@link draw_elements_count}.
@@ -239,4 +245,14 @@ public:
      * @param 	count	The number of instances to render.
      */
     void draw_instanced(int count) const;
+
+    /**
+     * Draws multiple instances of the geometry like {@link draw_instanced}, but with the instance indices starting at
+     * the specified base. The base is visible to the shaders as gl_BaseInstance (GL 4.6 or ARB_shader_draw_parameters)
+     * and offsets the instanced vertex attributes. Requires OpenGL 4.2.
+     *
+     * @param 	count        	The number of instances to render.
+     * @param 	base_instance	The index of the first instance.
+     */
+    void draw_instanced(int count, GLuint base_instance) const;
 };
@@ -0,0 +1,86 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+/**
+ * A read-only memory mapping of a whole file. The mapping is released when the object is destroyed.
+ */
+class MappedFile {
+
+    // ----------------------------------------------------------------------------
+    // Variables
+    // ----------------------------------------------------------------------------
+private:
+    /** The pointer to the beginning of the mapped data, or nullptr if no file is mapped. */
+    const char* mapped_data = nullptr;
+
+    /** The size of the mapped data (in bytes). */
+    size_t mapped_size = 0;
+
+#ifdef _WIN32
+    /** The handle of the opened file. */
+    void* file_handle = nullptr;
+
+    /** The handle of the file mapping object. */
+    void* mapping_handle = nullptr;
+#endif
+
+    // ----------------------------------------------------------------------------
+    // Constructors & Destructors
+    // ----------------------------------------------------------------------------
+public:
+    /** Creates a new @link MappedFile that does not map any file. */
+    MappedFile() = default;
+
+    /**
+     * Maps the specified file into memory. Use @link is_open to check whether the mapping succeeded.
+     *
+     * @param 	path	The path to the file to map.
+     */
+    explicit MappedFile(const std::filesystem::path& path);
+
+    /** The move constructor taking over the mapping of the other file. */
+    MappedFile(MappedFile&& other) noexcept;
+
+    MappedFile(const MappedFile&) = delete;
+
+    /** Releases the mapping. */
+    ~MappedFile();
+
+    // ----------------------------------------------------------------------------
+    // Operators
+    // ----------------------------------------------------------------------------
+public:
+    /** The move assignment taking over the mapping of the other file. */
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // ----------------------------------------------------------------------------
+    // Methods
+    // ----------------------------------------------------------------------------
+public:
+    /** Checks whether a (non-empty) file is mapped. */
+    bool is_open() const { return mapped_data != nullptr; }
+
+    /** Returns the pointer to the beginning of the mapped data. */
+    const char* data() const { return mapped_data; }
+
+    /** Returns the size of the mapped data (in bytes). */
+    size_t size() const { return mapped_size; }
+
+private:
+    /** Releases the mapping (if any). */
+    void close();
+
+    /** Exchanges the mappings of two files. */
+    void swap(MappedFile& other) noexcept;
+};
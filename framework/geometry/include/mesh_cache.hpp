@@ -0,0 +1,197 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include "glad/glad.h"
+#include "mapped_file.hpp"
+#include "mesh_data.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+/**
+ * The binary cache of an imported mesh. The cache file is stored next to the source model and contains the already
+ * interleaved vertices, indices, submeshes and materials, so that it can be memory-mapped and uploaded directly to the
+ * GPU without parsing the source file again.
+ * <p>
+ * The cache is considered valid only if it was written by the same format version and neither the source file nor the
+ * material libraries it references changed since then (their sizes and modification times match, or their content
+ * hashes match). A file that was only touched gets its new modification time stored, so it is not hashed again.
+ */
+class MeshCache {
+
+    // ----------------------------------------------------------------------------
+    // Static Variables
+    // ----------------------------------------------------------------------------
+public:
+    /** The version of the cache format, increase it whenever the layout of the data changes. */
+    static const uint32_t VERSION = 3;
+
+    /** The extension appended to the source file name to get the cache file name. */
+    static constexpr const char* EXTENSION = ".mesh";
+
+    /** The header stored at the beginning of every cache file. */
+    struct Header {
+        /** The magic number identifying the cache files. */
+        char magic[4];
+        /** The version of the cache format. */
+        uint32_t version;
+        /** The size of the source file (in bytes). */
+        uint64_t source_size;
+        /** The modification time of the source file (in ticks of the file clock). */
+        int64_t source_time;
+        /** The FNV-1a hash of the content of the source file. */
+        uint64_t source_hash;
+        /** The number of elements (floats) per vertex. */
+        uint32_t elements_per_vertex;
+        /** The number of vertices. */
+        uint32_t vertices_count;
+        /** The number of indices. */
+        uint32_t indices_count;
+        /** The type of the stored indices, i.e., GL_UNSIGNED_SHORT or GL_UNSIGNED_INT. */
+        uint32_t index_type;
+        /** The offset of the vertex data from the beginning of the file (in bytes). */
+        uint64_t vertices_offset;
+        /** The offset of the index data from the beginning of the file (in bytes). */
+        uint64_t indices_offset;
+        /** The number of submeshes. */
+        uint32_t submeshes_count;
+        /** The number of materials. */
+        uint32_t materials_count;
+        /** The offset of the submeshes from the beginning of the file (in bytes). */
+        uint64_t submeshes_offset;
+        /** The offset of the material records from the beginning of the file (in bytes). */
+        uint64_t materials_offset;
+        /** The offset of the strings referenced by the material and dependency records (in bytes). */
+        uint64_t strings_offset;
+        /** The size of the strings referenced by the material and dependency records (in bytes). */
+        uint64_t strings_size;
+        /** The number of files the mesh was imported from besides the source file, i.e., the material libraries. */
+        uint32_t dependencies_count;
+        /** The offset of the dependency records from the beginning of the file (in bytes). */
+        uint64_t dependencies_offset;
+        /** The minimum corner of the axis aligned bounding box of the (normalized) mesh. */
+        float aabb_min[3];
+        /** The maximum corner of the axis aligned bounding box of the (normalized) mesh. */
+        float aabb_max[3];
+        /** The center of the source model that was moved to the origin during the normalization. */
+        float center[3];
+        /** The scale used to fit the source model into a unit cube during the normalization. */
+        float scale;
+    };
+
+    /** The material as stored in the cache file, the strings are stored separately. */
+    struct MaterialRecord {
+        float ambient[3];
+        float diffuse[3];
+        float specular[3];
+        float shininess;
+        /** The offset and the size of the name in the strings section. */
+        uint32_t name_offset;
+        uint32_t name_size;
+        /** The offset and the size of the texture path (relative to the source model) in the strings section. */
+        uint32_t texture_offset;
+        uint32_t texture_size;
+    };
+
+    /** The size stored in a {@link DependencyRecord} of a file that did not exist when the cache was written. */
+    static const uint64_t MISSING_FILE = UINT64_MAX;
+
+    /** The file the mesh was imported from besides the source file (e.g., a material library). */
+    struct DependencyRecord {
+        /** The size of the file (in bytes), or {@link MISSING_FILE}. */
+        uint64_t size;
+        /** The modification time of the file (in ticks of the file clock). */
+        int64_t time;
+        /** The FNV-1a hash of the content of the file. */
+        uint64_t hash;
+        /** The offset and the size of the path (relative to the source model) in the strings section. */
+        uint32_t path_offset;
+        uint32_t path_size;
+    };
+
+    // ----------------------------------------------------------------------------
+    // Variables
+    // ----------------------------------------------------------------------------
+private:
+    /** The memory-mapped cache file. */
+    MappedFile file;
+
+    /** The directory of the source model, the texture paths are relative to it. */
+    std::filesystem::path source_directory;
+
+    // ----------------------------------------------------------------------------
+    // Constructors
+    // ----------------------------------------------------------------------------
+private:
+    MeshCache(MappedFile file, std::filesystem::path source_directory)
+        : file(std::move(file)), source_directory(std::move(source_directory)) {}
+
+    // ----------------------------------------------------------------------------
+    // Methods
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Returns the path of the cache file corresponding to the specified source model.
+     *
+     * @param 	source_path	The path to the source model.
+     */
+    static std::filesystem::path cache_path(const std::filesystem::path& source_path);
+
+    /**
+     * Maps the cache of the specified source model into memory.
+     *
+     * @param 	source_path	The path to the source model.
+     * @return	The mapped cache, or nothing if the cache does not exist or is out of date.
+     */
+    static std::optional<MeshCache> load(const std::filesystem::path& source_path);
+
+    /**
+     * Writes the cache of the specified source model. Failures are reported but otherwise ignored as the cache is
+     * only an optimization.
+     *
+     * @param 	source_path	The path to the source model.
+     * @param 	mesh	   	The mesh imported from the source model.
+     * @return	True if the cache was written successfully.
+     */
+    static bool store(const std::filesystem::path& source_path, const MeshData& mesh);
+
+    /** Returns the header of the mapped cache. */
+    const Header& header() const { return *reinterpret_cast<const Header*>(file.data()); }
+
+    /** Returns the pointer to the interleaved vertex data inside the mapped cache. */
+    const float* vertices() const { return reinterpret_cast<const float*>(file.data() + header().vertices_offset); }
+
+    /** Returns the pointer to the indices inside the mapped cache. */
+    const void* indices() const { return file.data() + header().indices_offset; }
+
+    /** Returns the submeshes stored in the cache. */
+    std::vector<Submesh> submeshes() const;
+
+    /** Returns the materials stored in the cache. */
+    std::vector<Material> materials() const;
+
+private:
+    /**
+     * Checks whether a file is the same as when the cache was written.
+     *
+     * @param 	path	The path to the file.
+     * @param 	size	The stored size of the file (or {@link MISSING_FILE}).
+     * @param 	time	The stored modification time, it is set to the current one if the file was only touched.
+     * @param 	hash	The stored hash of the file.
+     * @return	True if the content of the file did not change.
+     */
+    static bool is_up_to_date(const std::filesystem::path& path, uint64_t size, int64_t& time, uint64_t hash);
+
+    /** Overwrites the modification times stored at the specified offsets of a cache file. */
+    static void refresh_times(const std::filesystem::path& path, const std::vector<std::pair<uint64_t, int64_t>>& times);
+
+    /** Checks that the mapped data are large enough to contain everything the header refers to. */
+    bool is_consistent() const;
+};
@@ -0,0 +1,96 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include "glad/glad.h"
+#include "glm/vec3.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <vector>
+
+/** A range of triangles of a mesh that are drawn using the same material. */
+struct Submesh {
+    /** The offset of the first index of the submesh. */
+    uint32_t first_index = 0;
+
+    /** The number of indices of the submesh. */
+    uint32_t indices_count = 0;
+
+    /** The index of the material of the submesh, or -1 if no material is assigned. */
+    int32_t material_id = -1;
+};
+
+/** The material of a mesh as described by the MTL library of the source model. */
+struct Material {
+    /** The name of the material. */
+    std::string name;
+
+    /** The ambient color. */
+    glm::vec3 ambient{0.0f};
+
+    /** The diffuse color. */
+    glm::vec3 diffuse{1.0f};
+
+    /** The specular color. */
+    glm::vec3 specular{0.0f};
+
+    /** The specular exponent. */
+    float shininess = 1.0f;
+
+    /** The path to the diffuse texture, or an empty path if the material has no texture. */
+    std::filesystem::path diffuse_texture;
+};
+
+/**
+ * The CPU side representation of an imported mesh, i.e., the interleaved vertex data and the indices before they are
+ * uploaded to the GPU. The vertices always contain positions (3f), normals (3f) and texture coordinates (2f).
+ */
+struct MeshData {
+    /** The number of elements (floats) per vertex. */
+    static const int ELEMENTS_PER_VERTEX = 3 + 3 + 2;
+
+    /** The interleaved vertex data (positions, normals, texture coordinates). */
+    std::vector<float> vertices;
+
+    /** The indices describing the triangles of the mesh. */
+    std::vector<uint32_t> indices;
+
+    /** The ranges of {@link indices} drawn with the same material, they cover all indices. */
+    std::vector<Submesh> submeshes;
+
+    /** The materials referenced by the submeshes. */
+    std::vector<Material> materials;
+
+    /** The material libraries referenced by the source model, the cache is invalidated when they change. */
+    std::vector<std::filesystem::path> material_libraries;
+
+    /** The minimum corner of the axis aligned bounding box of the (normalized) mesh. */
+    glm::vec3 aabb_min{0.0f};
+
+    /** The maximum corner of the axis aligned bounding box of the (normalized) mesh. */
+    glm::vec3 aabb_max{0.0f};
+
+    /** The center of the source model that was moved to the origin during the normalization. */
+    glm::vec3 center{0.0f};
+
+    /** The scale used to fit the source model into a unit cube during the normalization. */
+    float scale = 1.0f;
+
+    /** Returns the number of vertices stored in the mesh. */
+    int vertices_count() const { return static_cast<int>(vertices.size() / ELEMENTS_PER_VERTEX); }
+
+    /** Returns the number of indices stored in the mesh. */
+    int indices_count() const { return static_cast<int>(indices.size()); }
+
+    /** Returns the smallest index type able to address all vertices, i.e., GL_UNSIGNED_SHORT or GL_UNSIGNED_INT. */
+    GLenum index_type() const {
+        return vertices_count() <= std::numeric_limits<uint16_t>::max() + 1 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    }
+};
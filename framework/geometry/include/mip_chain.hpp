@@ -0,0 +1,66 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * An RGBA8 image together with all its mipmap levels. The levels are stored one after another in {@link pixels}.
+ * <p>
+ * The chain is built on the CPU without touching OpenGL, so it can be created on any thread.
+ */
+struct MipChain {
+    /** The placement of a single mipmap level in {@link pixels}. */
+    struct Level {
+        int width;
+        int height;
+        size_t offset;
+    };
+
+    /** The levels from the largest (the original image) to 1x1. */
+    std::vector<Level> levels;
+
+    /** The RGBA8 pixels of all levels. */
+    std::vector<unsigned char> pixels;
+
+    /** Returns the pointer to the pixels of the specified level. */
+    const unsigned char* data(size_t level) const { return pixels.data() + levels[level].offset; }
+
+    /** Returns the width of the original image. */
+    int width() const { return levels.empty() ? 0 : levels[0].width; }
+
+    /** Returns the height of the original image. */
+    int height() const { return levels.empty() ? 0 : levels[0].height; }
+};
+
+/** The implementation of the 2x2 filter, the scalar one is kept mainly to verify the vectorized one. */
+enum class MipKernel {
+    /** SSE2 where available, scalar code elsewhere. */
+    SIMD,
+    /** Plain scalar code. */
+    SCALAR,
+};
+
+/**
+ * Builds the complete mipmap chain of an RGBA8 image using a 2x2 box filter. Every level is half the size of the previous
+ * one (rounded down, at least 1) down to 1x1.
+ * <p>
+ * With gamma correction the color channels are filtered in linear space, i.e., decoded from sRGB, averaged and encoded
+ * back, so that the smaller levels do not get darker. The alpha channel is always filtered linearly. The chain is kept
+ * in 14-bit linear precision between the levels, so the rounding errors do not accumulate.
+ *
+ * @param 	width		  	The width of the image.
+ * @param 	height		  	The height of the image.
+ * @param 	rgba		  	The RGBA8 pixels of the image.
+ * @param 	gamma_correct 	True if the color channels are sRGB encoded and should be filtered in linear space.
+ * @param 	kernel		  	The implementation of the filter, both produce identical results.
+ * @return	The image with all its mipmap levels.
+ */
+MipChain build_mip_chain(int width, int height, const unsigned char* rgba, bool gamma_correct = true,
+                         MipKernel kernel = MipKernel::SIMD);
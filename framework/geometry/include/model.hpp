@@ -0,0 +1,147 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include "geometry.hpp"
+#include "glm/vec3.hpp"
+#include "mesh_cache.hpp"
+#include "mesh_data.hpp"
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+/**
+ * The CPU side data of a model loaded by {@link Model::load_mesh}. A cached model stays memory-mapped until its geometry
+ * is created, so the vertices and the indices are uploaded straight from the cache file without any copy.
+ */
+struct LoadedMesh {
+    /** The mapped cache of the model, if the model was already imported. */
+    std::optional<MeshCache> cache;
+
+    /** The imported model, if it was not cached. */
+    MeshData mesh;
+
+    /** Checks whether the model could not be loaded. */
+    bool empty() const { return !cache && mesh.vertices.empty(); }
+
+    /** Returns the number of bytes uploaded to the GPU. */
+    size_t size() const;
+
+    /** Creates the geometry storing the vertices and the indices, must be called on the OpenGL thread. */
+    Geometry create_geometry() const;
+};
+
+/**
+ * A model consisting of multiple parts (shapes) that may use different materials. All parts share a single vertex and
+ * index buffer stored in {@link geometry}, every part is just a range of indices described by a {@link Submesh}.
+ * <p>
+ * Bind the VAO once and draw either the individual submeshes (e.g., after binding their materials) or all of them using
+ * a single multi-draw call.
+ *
+ * Example:
+ * <code>
+ *  Model model = Model::from_file("objects/room.obj");
+ *  ...
+ *  model.bind_vao();
+ *  for (size_t i = 0; i < model.submeshes.size(); i++) {
+ *      // bind the material model.materials[model.submeshes[i].material_id] ...
+ *      model.draw_submesh(i);
+ *  }
+ * </code>
+ */
+class Model {
+
+    // ----------------------------------------------------------------------------
+    // Variables
+    // ----------------------------------------------------------------------------
+public:
+    /** The geometry storing the vertices and the indices of all submeshes. */
+    Geometry geometry;
+
+    /** The ranges of indices drawn with the same material. */
+    std::vector<Submesh> submeshes;
+
+    /** The materials referenced by the submeshes. */
+    std::vector<Material> materials;
+
+    /** The minimum corner of the axis aligned bounding box of the (normalized) model. */
+    glm::vec3 aabb_min{0.0f};
+
+    /** The maximum corner of the axis aligned bounding box of the (normalized) model. */
+    glm::vec3 aabb_max{0.0f};
+
+private:
+    /** The numbers of indices of the submeshes passed to glMultiDrawElements. */
+    std::vector<GLsizei> draw_counts;
+
+    /** The byte offsets of the submeshes in the index buffer passed to glMultiDrawElements. */
+    std::vector<const void*> draw_offsets;
+
+    // ----------------------------------------------------------------------------
+    // Constructors
+    // ----------------------------------------------------------------------------
+public:
+    /** Creates a new empty @link Model object. */
+    Model() = default;
+
+    /**
+     * Creates a new @link Model object from an already uploaded geometry.
+     *
+     * @param 	geometry 	The geometry storing the vertices and the indices of all submeshes.
+     * @param 	submeshes	The ranges of indices drawn with the same material.
+     * @param 	materials	The materials referenced by the submeshes.
+     */
+    Model(Geometry geometry, std::vector<Submesh> submeshes, std::vector<Material> materials);
+
+    /**
+     * Creates a new @link Model object from an imported mesh.
+     *
+     * @param 	mesh	The imported mesh.
+     */
+    explicit Model(const MeshData& mesh);
+
+    // ----------------------------------------------------------------------------
+    // Methods
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Loads a model from a file, all shapes and materials are loaded.
+     *
+     * @param 	file_path	The file name.
+     * @return	A loaded model (empty if the file could not be loaded).
+     */
+    static Model from_file(const std::filesystem::path& file_path);
+
+    /**
+     * Loads the CPU side data of a model, i.e., maps the cache or imports the model and caches it. The method does
+     * not touch OpenGL, so it can be called from any thread.
+     *
+     * @param 	file_path	 	The file name.
+     * @param 	threads_count	The maximum number of threads parsing the model (0 to use all hardware threads), loaders
+     * 							running on several threads should use 1 so that they do not oversubscribe the CPU.
+     * @return	The loaded mesh (empty if the file could not be loaded).
+     */
+    static LoadedMesh load_mesh(const std::filesystem::path& file_path, unsigned int threads_count = 0);
+
+    /** Binds the VAO shared by all submeshes. */
+    void bind_vao() const { geometry.bind_vao(); }
+
+    /**
+     * Draws a single submesh. The VAO must be bound using {@link bind_vao} beforehand.
+     *
+     * @param 	submesh	The index of the submesh to draw.
+     */
+    void draw_submesh(size_t submesh) const;
+
+    /** Binds the VAO and draws all submeshes using a single glMultiDrawElements call. */
+    void draw() const;
+
+private:
+    /** Prepares the arguments of the multi-draw call. */
+    void init_draws();
+};
@@ -0,0 +1,84 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include "tiny_obj_loader.h"
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/**
+ * The multi-threaded parser of Wavefront OBJ files.
+ * <p>
+ * The file is split into chunks at line boundaries and the 'v', 'vn', 'vt' and 'f' records of every chunk are parsed on
+ * a separate thread. The chunks are then stitched together in order: the relative (negative) face indices are resolved
+ * against the global attribute counts and the polygons are triangulated exactly like tinyobjloader does it, so the
+ * result matches the output of tinyobj::ObjReader.
+ */
+class ObjParser {
+
+    // ----------------------------------------------------------------------------
+    // Nested Types
+    // ----------------------------------------------------------------------------
+public:
+    /** A contiguous range of triangles sharing the same object/group name and material. */
+    struct Shape {
+        /** The name of the object or group ('o' and 'g' records). */
+        std::string name;
+        /** The name of the material ('usemtl' record), empty if no material was used. */
+        std::string material;
+        /** The offset of the first index of the shape in {@link Result::indices}. */
+        size_t first_index = 0;
+        /** The number of indices of the shape. */
+        size_t indices_count = 0;
+    };
+
+    /** The parsed content of an OBJ file. */
+    struct Result {
+        /** The vertex positions (3 floats per vertex). */
+        std::vector<float> vertices;
+        /** The vertex normals (3 floats per normal). */
+        std::vector<float> normals;
+        /** The texture coordinates (2 floats per coordinate). */
+        std::vector<float> texcoords;
+        /** The triangulated faces, three indices per triangle. */
+        std::vector<tinyobj::index_t> indices;
+        /** The shapes in the order in which they appear in the file. */
+        std::vector<Shape> shapes;
+        /** The material libraries referenced by 'mtllib' records. */
+        std::vector<std::string> material_libraries;
+        /** The warnings produced while parsing the file. */
+        std::string warning;
+        /** The flag determining whether the file was read successfully. */
+        bool valid = false;
+    };
+
+    // ----------------------------------------------------------------------------
+    // Methods
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Parses the specified OBJ file.
+     *
+     * @param 	path		 	The path to the OBJ file.
+     * @param 	threads_count	The maximum number of threads to use (0 to use all hardware threads).
+     * @return	The parsed content of the file.
+     */
+    static Result parse(const std::filesystem::path& path, unsigned int threads_count = 0);
+
+    /**
+     * Parses the OBJ data stored in memory.
+     *
+     * @param 	data		 	The content of an OBJ file.
+     * @param 	size		 	The size of the content (in bytes).
+     * @param 	threads_count	The maximum number of threads to use (0 to use all hardware threads).
+     * @return	The parsed content.
+     */
+    static Result parse(const char* data, size_t size, unsigned int threads_count = 0);
+};
@@ -0,0 +1,322 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "block_compression.hpp"
+#include "file_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <system_error>
+
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+
+namespace {
+    /** The magic number identifying the cache files. */
+    const char cache_magic[4] = {'P', 'G', 'L', 'T'};
+
+    /** The header stored at the beginning of every cache file, followed by the level records and the blocks. */
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        /** The size of the source file (in bytes). */
+        uint64_t source_size;
+        /** The modification time of the source file (in ticks of the file clock). */
+        int64_t source_time;
+        /** The FNV-1a hash of the content of the source file. */
+        uint64_t source_hash;
+        /** The OpenGL internal format of the blocks. */
+        uint32_t format;
+        /** The number of mipmap levels. */
+        uint32_t levels_count;
+        /** The size of all blocks (in bytes). */
+        uint64_t blocks_size;
+    };
+
+    /** The level as stored in the cache file, the offset is relative to the beginning of the blocks. */
+    struct LevelRecord {
+        uint32_t width;
+        uint32_t height;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    /** Returns the size (in bytes) of a single block of the specified format. */
+    size_t block_size(uint32_t format) { return format == CompressedImage::BC1 ? 8 : 16; }
+
+    /** Returns the size (in bytes) of a level of the specified dimensions. */
+    size_t level_size(uint32_t format, int width, int height) {
+        return size_t((width + 3) / 4) * size_t((height + 3) / 4) * block_size(format);
+    }
+
+    /** Expands a 5:6:5 color into RGB8. */
+    void unpack_565(uint16_t color, unsigned char* rgb) {
+        const int r = (color >> 11) & 31;
+        const int g = (color >> 5) & 63;
+        const int b = color & 31;
+        rgb[0] = static_cast<unsigned char>((r << 3) | (r >> 2));
+        rgb[1] = static_cast<unsigned char>((g << 2) | (g >> 4));
+        rgb[2] = static_cast<unsigned char>((b << 3) | (b >> 2));
+    }
+
+    /** Decodes the color part of a block into 16 RGBA8 pixels. The BC3 color blocks always use 4 colors. */
+    void decode_color_block(const unsigned char* block, bool four_colors_only, unsigned char* pixels) {
+        const uint16_t color0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+        const uint16_t color1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+
+        unsigned char palette[4][4];
+        unpack_565(color0, palette[0]);
+        unpack_565(color1, palette[1]);
+        palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+        for (int c = 0; c < 3; c++) {
+            if (four_colors_only || color0 > color1) {
+                palette[2][c] = static_cast<unsigned char>((2 * palette[0][c] + palette[1][c] + 1) / 3);
+                palette[3][c] = static_cast<unsigned char>((palette[0][c] + 2 * palette[1][c] + 1) / 3);
+            } else {
+                palette[2][c] = static_cast<unsigned char>((palette[0][c] + palette[1][c] + 1) / 2);
+                palette[3][c] = 0;
+            }
+        }
+        if (!four_colors_only && color0 <= color1) {
+            palette[3][3] = 0;
+        }
+
+        const uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (uint32_t(block[7]) << 24);
+        for (int i = 0; i < 16; i++) {
+            std::memcpy(pixels + 4 * i, palette[(indices >> (2 * i)) & 3], 4);
+        }
+    }
+
+    /** Decodes the alpha part of a BC3 block into the alpha channel of 16 RGBA8 pixels. */
+    void decode_alpha_block(const unsigned char* block, unsigned char* pixels) {
+        const int alpha0 = block[0];
+        const int alpha1 = block[1];
+
+        int palette[8] = {alpha0, alpha1};
+        if (alpha0 > alpha1) {
+            for (int i = 1; i < 7; i++) {
+                palette[i + 1] = ((7 - i) * alpha0 + i * alpha1 + 3) / 7;
+            }
+        } else {
+            for (int i = 1; i < 5; i++) {
+                palette[i + 1] = ((5 - i) * alpha0 + i * alpha1 + 2) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t indices = 0;
+        for (int i = 0; i < 6; i++) {
+            indices |= uint64_t{block[2 + i]} << (8 * i);
+        }
+        for (int i = 0; i < 16; i++) {
+            pixels[4 * i + 3] = static_cast<unsigned char>(palette[(indices >> (3 * i)) & 7]);
+        }
+    }
+} // namespace
+
+// ----------------------------------------------------------------------------
+// CompressedImage
+// ----------------------------------------------------------------------------
+
+std::filesystem::path CompressedImage::cache_path(const std::filesystem::path& source_path) {
+    std::filesystem::path path = source_path;
+    path += EXTENSION;
+    return path;
+}
+
+std::optional<CompressedImage> CompressedImage::load(const std::filesystem::path& source_path) {
+    std::error_code error;
+    const uint64_t source_size = std::filesystem::file_size(source_path, error);
+    const auto source_time = std::filesystem::last_write_time(source_path, error);
+    if (error) {
+        return std::nullopt;
+    }
+
+    std::ifstream input{cache_path(source_path), std::ios::binary};
+    Header header{};
+    if (!input.read(reinterpret_cast<char*>(&header), sizeof(Header))) {
+        return std::nullopt;
+    }
+    if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 || header.version != VERSION
+        || header.source_size != source_size || (header.format != BC1 && header.format != BC3)
+        || header.levels_count == 0 || header.levels_count > 32) {
+        return std::nullopt;
+    }
+
+    // The modification time changes also when the file is only touched (e.g., by a checkout), so the content is
+    // compared before the cache is discarded.
+    if (header.source_time != source_time.time_since_epoch().count()
+        && header.source_hash != FileUtils::hash_file(source_path)) {
+        return std::nullopt;
+    }
+
+    std::vector<LevelRecord> records(header.levels_count);
+    if (!input.read(reinterpret_cast<char*>(records.data()), std::streamsize(records.size() * sizeof(LevelRecord)))) {
+        return std::nullopt;
+    }
+
+    // The levels must form a complete chain and must not point outside of the blocks.
+    CompressedImage image;
+    image.format = header.format;
+    for (size_t level = 0; level < records.size(); level++) {
+        const LevelRecord& record = records[level];
+        const bool valid_size = level == 0 ? record.width > 0 && record.height > 0
+                                           : record.width == std::max(1u, records[level - 1].width / 2)
+                                                 && record.height == std::max(1u, records[level - 1].height / 2);
+        if (!valid_size || record.size != level_size(header.format, int(record.width), int(record.height))
+            || record.offset + record.size > header.blocks_size) {
+            return std::nullopt;
+        }
+        image.levels.push_back({int(record.width), int(record.height), size_t(record.offset), size_t(record.size)});
+    }
+    if (image.levels.back().width != 1 || image.levels.back().height != 1) {
+        return std::nullopt;
+    }
+
+    image.blocks.resize(header.blocks_size);
+    if (!input.read(reinterpret_cast<char*>(image.blocks.data()), std::streamsize(image.blocks.size()))) {
+        return std::nullopt;
+    }
+
+    return image;
+}
+
+bool CompressedImage::store(const std::filesystem::path& source_path) const {
+    std::error_code error;
+    const uint64_t source_size = std::filesystem::file_size(source_path, error);
+    const auto source_time = std::filesystem::last_write_time(source_path, error);
+    if (error) {
+        return false;
+    }
+
+    Header header{};
+    std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = VERSION;
+    header.source_size = source_size;
+    header.source_time = source_time.time_since_epoch().count();
+    header.source_hash = FileUtils::hash_file(source_path);
+    header.format = format;
+    header.levels_count = static_cast<uint32_t>(levels.size());
+    header.blocks_size = blocks.size();
+
+    std::vector<LevelRecord> records;
+    for (const Level& level : levels) {
+        records.push_back({uint32_t(level.width), uint32_t(level.height), level.offset, level.size});
+    }
+
+    return FileUtils::write_atomically(cache_path(source_path), [&](std::ostream& output) {
+        output.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        output.write(reinterpret_cast<const char*>(records.data()), std::streamsize(records.size() * sizeof(LevelRecord)));
+        output.write(reinterpret_cast<const char*>(blocks.data()), std::streamsize(blocks.size()));
+    });
+}
+
+// ----------------------------------------------------------------------------
+// Functions
+// ----------------------------------------------------------------------------
+
+CompressedImage compress_image(const MipChain& image, bool high_quality) {
+    CompressedImage compressed;
+    if (image.levels.empty()) {
+        return compressed;
+    }
+
+    // The smaller levels are averages of the first one, so they are opaque if the first one is.
+    const size_t pixels_count = size_t(image.width()) * size_t(image.height());
+    bool opaque = true;
+    for (size_t i = 0; i < pixels_count && opaque; i++) {
+        opaque = image.pixels[4 * i + 3] == 255;
+    }
+    compressed.format = opaque ? CompressedImage::BC1 : CompressedImage::BC3;
+
+    size_t size = 0;
+    for (const MipChain::Level& level : image.levels) {
+        const size_t level_bytes = level_size(compressed.format, level.width, level.height);
+        compressed.levels.push_back({level.width, level.height, size, level_bytes});
+        size += level_bytes;
+    }
+    compressed.blocks.resize(size);
+
+    const int mode = high_quality ? STB_DXT_HIGHQUAL : STB_DXT_NORMAL;
+    const size_t bytes_per_block = block_size(compressed.format);
+    for (size_t level = 0; level < image.levels.size(); level++) {
+        const int width = image.levels[level].width;
+        const int height = image.levels[level].height;
+        const unsigned char* pixels = image.data(level);
+        unsigned char* target = compressed.blocks.data() + compressed.levels[level].offset;
+
+        unsigned char block[16 * 4];
+        for (int by = 0; by < height; by += 4) {
+            for (int bx = 0; bx < width; bx += 4) {
+                for (int y = 0; y < 4; y++) {
+                    const int source_y = std::min(by + y, height - 1);
+                    for (int x = 0; x < 4; x++) {
+                        const int source_x = std::min(bx + x, width - 1);
+                        std::memcpy(block + 4 * (4 * y + x), pixels + (size_t(source_y) * width + source_x) * 4, 4);
+                    }
+                }
+                stb_compress_dxt_block(target, block, opaque ? 0 : 1, mode);
+                target += bytes_per_block;
+            }
+        }
+    }
+
+    return compressed;
+}
+
+std::vector<unsigned char> decompress_level(const CompressedImage& image, size_t level) {
+    const int width = image.levels[level].width;
+    const int height = image.levels[level].height;
+    const bool has_alpha = image.format == CompressedImage::BC3;
+    const unsigned char* block = image.data(level);
+
+    std::vector<unsigned char> pixels(size_t(width) * size_t(height) * 4);
+    unsigned char decoded[16 * 4];
+    for (int by = 0; by < height; by += 4) {
+        for (int bx = 0; bx < width; bx += 4) {
+            if (has_alpha) {
+                decode_color_block(block + 8, true, decoded);
+                decode_alpha_block(block, decoded);
+            } else {
+                decode_color_block(block, false, decoded);
+            }
+            block += block_size(image.format);
+
+            for (int y = 0; y < 4 && by + y < height; y++) {
+                for (int x = 0; x < 4 && bx + x < width; x++) {
+                    std::memcpy(pixels.data() + (size_t(by + y) * width + bx + x) * 4, decoded + 4 * (4 * y + x), 4);
+                }
+            }
+        }
+    }
+
+    return pixels;
+}
+
+double compute_psnr(const MipChain& image, const CompressedImage& compressed, size_t level) {
+    const std::vector<unsigned char> decoded = decompress_level(compressed, level);
+    const unsigned char* original = image.data(level);
+    const int channels = compressed.format == CompressedImage::BC3 ? 4 : 3;
+
+    double squared_error = 0.0;
+    for (size_t i = 0; i < decoded.size(); i += 4) {
+        for (int c = 0; c < channels; c++) {
+            const double difference = double(decoded[i + c]) - double(original[i + c]);
+            squared_error += difference * difference;
+        }
+    }
+    if (squared_error == 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    const double mean_squared_error = squared_error / (double(decoded.size() / 4) * channels);
+    return 10.0 * std::log10(255.0 * 255.0 / mean_squared_error);
+}
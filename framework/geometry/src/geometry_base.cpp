@@ -7,9 +7,7 @@
 
 #include "geometry_base.hpp"
 #include "geometry.hpp"
-#include "tiny_obj_loader.h"
-#include "glm/vec3.hpp"
-#include <iostream>
+#include "model.hpp"
 
 // ----------------------------------------------------------------------------
 // Constructors & Destructors
@@ -112,6 +110,7 @@ void Geometry_Base::swap_fields(Geometry_Base& first, Geometry_Base& second) con
     swap(first.mode, second.mode);
     swap(first.draw_arrays_count, second.draw_arrays_count);
     swap(first.draw_elements_count, second.draw_elements_count);
+    swap(first.index_type, second.index_type);
     swap(first.patch_vertices, second.patch_vertices);
     swap(first.position_loc, second.position_loc);
     swap(first.normal_loc, second.normal_loc);
@@ -138,6 +137,10 @@ void Geometry_Base::bind_vao() const {
     glBindVertexArray(vao);
 }
 
+GLsizei Geometry_Base::index_size() const {
+    return index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
 void Geometry_Base::draw() const {
     bind_vao();
 
@@ -146,7 +149,7 @@ void Geometry_Base::draw() const {
     }
 
     if (draw_elements_count > 0) {
-        glDrawElements(mode, draw_elements_count, GL_UNSIGNED_INT, nullptr);
+        glDrawElements(mode, draw_elements_count, index_type, nullptr);
     } else {
         glDrawArrays(mode, 0, draw_arrays_count);
     }
@@ -160,110 +163,27 @@ void Geometry_Base::draw_instanced(int count) const {
     }
 
     if (draw_elements_count > 0) {
-        glDrawElementsInstanced(mode, draw_elements_count, GL_UNSIGNED_INT, nullptr, count);
+        glDrawElementsInstanced(mode, draw_elements_count, index_type, nullptr, count);
     } else {
         glDrawArraysInstanced(mode, 0, draw_arrays_count, count);
     }
 }
 
-Geometry Geometry::from_file(std::filesystem::path path) {
-    const std::string extension = path.extension().generic_string();
-
-    if (extension == ".obj") {
-        tinyobj::ObjReader reader;
-
-        if (!reader.ParseFromFile(path.generic_string())) {
-            if (!reader.Error().empty()) {
-                std::cerr << "TinyObjReader: " << reader.Error();
-            }
-        }
-
-        if (!reader.Warning().empty()) {
-            std::cout << "TinyObjReader: " << reader.Warning();
-        }
-
-        auto& attrib = reader.GetAttrib();
-        auto& shapes = reader.GetShapes();
-        auto& materials = reader.GetMaterials();
-
-        // Take only the first shape found
-        const tinyobj::shape_t& shape = shapes[0];
-
-        std::vector<float> positions;
-        std::vector<float> normals;
-        std::vector<float> tex_coords;
-
-        glm::vec3 min{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
-        glm::vec3 max{std::numeric_limits<float>::min(), std::numeric_limits<float>::min(), std::numeric_limits<float>::min()};
-
-        // Loop over faces(polygon)
-        size_t index_offset = 0;
-        for (size_t f = 0; f < shape.mesh.num_face_vertices.size(); f++) {
-            // Loop over vertices in the face.
-            for (size_t v = 0; v < 3; v++) {
-                // Access to vertex
-                tinyobj::index_t idx = shape.mesh.indices[index_offset + v];
-
-                tinyobj::real_t vx = attrib.vertices[3 * idx.vertex_index + 0];
-                tinyobj::real_t vy = attrib.vertices[3 * idx.vertex_index + 1];
-                tinyobj::real_t vz = attrib.vertices[3 * idx.vertex_index + 2];
-
-                tinyobj::real_t nx;
-                tinyobj::real_t ny;
-                tinyobj::real_t nz;
-                if (!attrib.normals.empty()) {
-                    nx = attrib.normals[3 * idx.normal_index + 0];
-                    ny = attrib.normals[3 * idx.normal_index + 1];
-                    nz = attrib.normals[3 * idx.normal_index + 2];
-                } else {
-                    nx = 0.0;
-                    ny = 0.0;
-                    nz = 0.0;
-                }
-
-                tinyobj::real_t tx;
-                tinyobj::real_t ty;
-                if (!attrib.texcoords.empty()) {
-                    tx = attrib.texcoords[2 * idx.texcoord_index + 0];
-                    ty = attrib.texcoords[2 * idx.texcoord_index + 1];
-                } else {
-                    tx = 0.0;
-                    ty = 0.0;
-                }
-
-                min.x = std::min(min.x, vx);
-                min.y = std::min(min.y, vy);
-                min.z = std::min(min.z, vz);
-                max.x = std::max(max.x, vx);
-                max.y = std::max(max.y, vy);
-                max.z = std::max(max.z, vz);
-
-                positions.insert(positions.end(), {vx, vy, vz});
-                normals.insert(normals.end(), {nx, ny, nz});
-                tex_coords.insert(tex_coords.end(), {tx, ty});
-            }
-            index_offset += 3;
-        }
-
-        glm::vec3 diff = max - min;
-        glm::vec3 center = min + 0.5f * diff;
-        min -= center;
-        max -= center;
-        for (int i = 0; i < positions.size(); i += 3) {
-            positions[i + 0] -= center.x;
-            positions[i + 1] -= center.y;
-            positions[i + 2] -= center.z;
-
-            positions[i + 0] /= std::max(std::max(diff.x, diff.y), diff.z);
-            positions[i + 1] /= std::max(std::max(diff.x, diff.y), diff.z);
-            positions[i + 2] /= std::max(std::max(diff.x, diff.y), diff.z);
-        }
+void Geometry_Base::draw_instanced(int count, GLuint base_instance) const {
+    bind_vao();
 
-        const int elements_per_vertex = 3 + (!normals.empty() ? 3 : 0) + (!tex_coords.empty() ? 2 : 0);
+    if (mode == GL_PATCHES) {
+        glPatchParameteri(GL_PATCH_VERTICES, patch_vertices);
+    }
 
-        return Geometry{GL_TRIANGLES, positions, {/*indices*/}, normals, {/*colors*/}, tex_coords};
+    if (draw_elements_count > 0) {
+        glDrawElementsInstancedBaseInstance(mode, draw_elements_count, index_type, nullptr, count, base_instance);
+    } else {
+        glDrawArraysInstancedBaseInstance(mode, 0, draw_arrays_count, count, base_instance);
     }
-    std::cerr << "Extension " << extension << " not supported" << std::endl;
+}
 
-    return Geometry{};
+Geometry Geometry::from_file(std::filesystem::path path) {
+    // All shapes of the model are stored in a single geometry, the submeshes are ignored.
+    return std::move(Model::from_file(path).geometry);
 }
@@ -0,0 +1,122 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "mapped_file.hpp"
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ----------------------------------------------------------------------------
+// Constructors & Destructors
+// ----------------------------------------------------------------------------
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    file_handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        file_handle = nullptr;
+        return;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0) {
+        close();
+        return;
+    }
+
+    mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_handle) {
+        close();
+        return;
+    }
+
+    mapped_data = static_cast<const char*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    mapped_size = mapped_data ? static_cast<size_t>(file_size.QuadPart) : 0;
+    if (!mapped_data) {
+        close();
+    }
+}
+#else
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    const int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return;
+    }
+
+    struct stat file_stat;
+    if (fstat(descriptor, &file_stat) == 0 && file_stat.st_size > 0) {
+        void* data = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (data != MAP_FAILED) {
+            mapped_data = static_cast<const char*>(data);
+            mapped_size = static_cast<size_t>(file_stat.st_size);
+        }
+    }
+
+    // The mapping stays valid even after the descriptor is closed.
+    ::close(descriptor);
+}
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept { swap(other); }
+
+MappedFile::~MappedFile() { close(); }
+
+// ----------------------------------------------------------------------------
+// Operators
+// ----------------------------------------------------------------------------
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    MappedFile released{std::move(other)};
+    swap(released);
+    return *this;
+}
+
+// ----------------------------------------------------------------------------
+// Methods
+// ----------------------------------------------------------------------------
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (mapped_data) {
+        UnmapViewOfFile(mapped_data);
+    }
+    if (mapping_handle) {
+        CloseHandle(mapping_handle);
+    }
+    if (file_handle) {
+        CloseHandle(file_handle);
+    }
+    mapping_handle = nullptr;
+    file_handle = nullptr;
+#else
+    if (mapped_data) {
+        munmap(const_cast<char*>(mapped_data), mapped_size);
+    }
+#endif
+    mapped_data = nullptr;
+    mapped_size = 0;
+}
+
+void MappedFile::swap(MappedFile& other) noexcept {
+    using std::swap;
+
+    swap(mapped_data, other.mapped_data);
+    swap(mapped_size, other.mapped_size);
+#ifdef _WIN32
+    swap(file_handle, other.file_handle);
+    swap(mapping_handle, other.mapping_handle);
+#endif
+}
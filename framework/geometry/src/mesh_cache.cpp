@@ -0,0 +1,309 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "mesh_cache.hpp"
+#include "file_utils.h"
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+namespace {
+    /** The magic number identifying the cache files. */
+    const char cache_magic[4] = {'P', 'G', 'L', 'M'};
+
+    /** Rounds the specified offset up to the multiple of 16 bytes. */
+    uint64_t align_offset(uint64_t offset) { return (offset + 15) & ~uint64_t{15}; }
+
+    /** Returns the size (in bytes) of a single index of the specified type. */
+    uint64_t index_size(uint32_t index_type) { return index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t); }
+} // namespace
+
+// ----------------------------------------------------------------------------
+// Methods
+// ----------------------------------------------------------------------------
+
+std::filesystem::path MeshCache::cache_path(const std::filesystem::path& source_path) {
+    std::filesystem::path path = source_path;
+    path += EXTENSION;
+    return path;
+}
+
+std::optional<MeshCache> MeshCache::load(const std::filesystem::path& source_path) {
+    const std::filesystem::path path = cache_path(source_path);
+    MeshCache cache{MappedFile{path}, source_path.parent_path()};
+    if (!cache.file.is_open() || cache.file.size() < sizeof(Header)) {
+        return std::nullopt;
+    }
+
+    const Header& header = cache.header();
+    if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 || header.version != VERSION
+        || !cache.is_consistent()) {
+        return std::nullopt;
+    }
+
+    // The new modification times of the touched files and the offsets at which they are stored in the cache.
+    std::vector<std::pair<uint64_t, int64_t>> touched_times;
+
+    int64_t source_time = header.source_time;
+    if (!is_up_to_date(source_path, header.source_size, source_time, header.source_hash)) {
+        return std::nullopt;
+    }
+    if (source_time != header.source_time) {
+        touched_times.emplace_back(offsetof(Header, source_time), source_time);
+    }
+
+    const DependencyRecord* dependencies =
+        reinterpret_cast<const DependencyRecord*>(cache.file.data() + header.dependencies_offset);
+    const char* strings = cache.file.data() + header.strings_offset;
+    for (uint32_t d = 0; d < header.dependencies_count; d++) {
+        const DependencyRecord& dependency = dependencies[d];
+        const std::string dependency_path(strings + dependency.path_offset, dependency.path_size);
+
+        int64_t time = dependency.time;
+        if (!is_up_to_date(cache.source_directory / dependency_path, dependency.size, time, dependency.hash)) {
+            return std::nullopt;
+        }
+        if (time != dependency.time) {
+            touched_times.emplace_back(
+                header.dependencies_offset + d * sizeof(DependencyRecord) + offsetof(DependencyRecord, time), time);
+        }
+    }
+
+    if (touched_times.empty()) {
+        return cache;
+    }
+
+    // The mapping is read-only (and locks the file on Windows), so it is released while the times are written.
+    cache.file = MappedFile{};
+    refresh_times(path, touched_times);
+    cache.file = MappedFile{path};
+    if (!cache.file.is_open() || cache.file.size() < sizeof(Header) || !cache.is_consistent()) {
+        return std::nullopt;
+    }
+
+    return cache;
+}
+
+bool MeshCache::store(const std::filesystem::path& source_path, const MeshData& mesh) {
+    std::error_code error;
+    const uint64_t source_size = std::filesystem::file_size(source_path, error);
+    const auto source_time = std::filesystem::last_write_time(source_path, error);
+    if (error) {
+        return false;
+    }
+
+    // Serializes the materials, their names and texture paths are stored in a separate section.
+    const std::filesystem::path source_directory = source_path.parent_path();
+    std::vector<MaterialRecord> material_records;
+    std::string strings;
+    for (const Material& material : mesh.materials) {
+        const std::string texture = source_directory.empty() || material.diffuse_texture.empty()
+                                        ? material.diffuse_texture.generic_string()
+                                        : material.diffuse_texture.lexically_relative(source_directory).generic_string();
+
+        MaterialRecord record{};
+        for (int i = 0; i < 3; i++) {
+            record.ambient[i] = material.ambient[i];
+            record.diffuse[i] = material.diffuse[i];
+            record.specular[i] = material.specular[i];
+        }
+        record.shininess = material.shininess;
+        record.name_offset = static_cast<uint32_t>(strings.size());
+        record.name_size = static_cast<uint32_t>(material.name.size());
+        strings += material.name;
+        record.texture_offset = static_cast<uint32_t>(strings.size());
+        record.texture_size = static_cast<uint32_t>(texture.size());
+        strings += texture;
+        material_records.push_back(record);
+    }
+
+    // The material libraries are stored with their sizes, modification times and hashes just like the source file.
+    std::vector<DependencyRecord> dependency_records;
+    for (const std::filesystem::path& library : mesh.material_libraries) {
+        const std::string library_path = source_directory.empty() ? library.generic_string()
+                                                                  : library.lexically_relative(source_directory).generic_string();
+
+        DependencyRecord record{};
+        std::error_code library_error;
+        record.size = std::filesystem::file_size(library, library_error);
+        record.time = std::filesystem::last_write_time(library, library_error).time_since_epoch().count();
+        if (library_error) {
+            record.size = MISSING_FILE;
+            record.time = 0;
+        } else {
+            record.hash = FileUtils::hash_file(library);
+        }
+        record.path_offset = static_cast<uint32_t>(strings.size());
+        record.path_size = static_cast<uint32_t>(library_path.size());
+        strings += library_path;
+        dependency_records.push_back(record);
+    }
+
+    Header header{};
+    std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = VERSION;
+    header.source_size = source_size;
+    header.source_time = source_time.time_since_epoch().count();
+    header.source_hash = FileUtils::hash_file(source_path);
+    header.elements_per_vertex = MeshData::ELEMENTS_PER_VERTEX;
+    header.vertices_count = static_cast<uint32_t>(mesh.vertices_count());
+    header.indices_count = static_cast<uint32_t>(mesh.indices_count());
+    header.index_type = mesh.index_type();
+    header.vertices_offset = align_offset(sizeof(Header));
+    header.indices_offset = align_offset(header.vertices_offset + mesh.vertices.size() * sizeof(float));
+    header.submeshes_count = static_cast<uint32_t>(mesh.submeshes.size());
+    header.materials_count = static_cast<uint32_t>(material_records.size());
+    header.submeshes_offset = align_offset(header.indices_offset + mesh.indices.size() * index_size(header.index_type));
+    header.materials_offset = align_offset(header.submeshes_offset + mesh.submeshes.size() * sizeof(Submesh));
+    header.dependencies_count = static_cast<uint32_t>(dependency_records.size());
+    header.dependencies_offset = header.materials_offset + material_records.size() * sizeof(MaterialRecord);
+    header.strings_offset = header.dependencies_offset + dependency_records.size() * sizeof(DependencyRecord);
+    header.strings_size = strings.size();
+    for (int i = 0; i < 3; i++) {
+        header.aabb_min[i] = mesh.aabb_min[i];
+        header.aabb_max[i] = mesh.aabb_max[i];
+        header.center[i] = mesh.center[i];
+    }
+    header.scale = mesh.scale;
+
+    return FileUtils::write_atomically(cache_path(source_path), [&](std::ostream& output) {
+        // Writes the section at the specified offset, padding the gap after the previous section with zeros.
+        uint64_t written = 0;
+        const auto write_section = [&output, &written](uint64_t offset, const void* data, uint64_t size) {
+            const char padding[16] = {};
+            output.write(padding, static_cast<std::streamsize>(offset - written));
+            output.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+            written = offset + size;
+        };
+
+        write_section(0, &header, sizeof(Header));
+        write_section(header.vertices_offset, mesh.vertices.data(), mesh.vertices.size() * sizeof(float));
+        if (header.index_type == GL_UNSIGNED_SHORT) {
+            const std::vector<uint16_t> short_indices(mesh.indices.begin(), mesh.indices.end());
+            write_section(header.indices_offset, short_indices.data(), short_indices.size() * sizeof(uint16_t));
+        } else {
+            write_section(header.indices_offset, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+        }
+        write_section(header.submeshes_offset, mesh.submeshes.data(), mesh.submeshes.size() * sizeof(Submesh));
+        write_section(header.materials_offset, material_records.data(), material_records.size() * sizeof(MaterialRecord));
+        write_section(header.dependencies_offset, dependency_records.data(),
+                      dependency_records.size() * sizeof(DependencyRecord));
+        write_section(header.strings_offset, strings.data(), strings.size());
+    });
+}
+
+std::vector<Submesh> MeshCache::submeshes() const {
+    const Submesh* first = reinterpret_cast<const Submesh*>(file.data() + header().submeshes_offset);
+    return std::vector<Submesh>(first, first + header().submeshes_count);
+}
+
+std::vector<Material> MeshCache::materials() const {
+    const MaterialRecord* records = reinterpret_cast<const MaterialRecord*>(file.data() + header().materials_offset);
+    const char* strings = file.data() + header().strings_offset;
+
+    std::vector<Material> materials;
+    for (uint32_t m = 0; m < header().materials_count; m++) {
+        const MaterialRecord& record = records[m];
+
+        Material& material = materials.emplace_back();
+        material.name.assign(strings + record.name_offset, record.name_size);
+        material.ambient = glm::vec3(record.ambient[0], record.ambient[1], record.ambient[2]);
+        material.diffuse = glm::vec3(record.diffuse[0], record.diffuse[1], record.diffuse[2]);
+        material.specular = glm::vec3(record.specular[0], record.specular[1], record.specular[2]);
+        material.shininess = record.shininess;
+        if (record.texture_size > 0) {
+            material.diffuse_texture = source_directory / std::string(strings + record.texture_offset, record.texture_size);
+        }
+    }
+
+    return materials;
+}
+
+bool MeshCache::is_up_to_date(const std::filesystem::path& path, uint64_t size, int64_t& time, uint64_t hash) {
+    std::error_code error;
+    const uint64_t current_size = std::filesystem::file_size(path, error);
+    const int64_t current_time = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+    if (error || size == MISSING_FILE) {
+        return error && size == MISSING_FILE;
+    }
+    if (current_size != size) {
+        return false;
+    }
+
+    // The modification time changes also when the file is only touched (e.g., by a checkout), so the content is
+    // compared before the cache is discarded.
+    if (current_time != time) {
+        if (FileUtils::hash_file(path) != hash) {
+            return false;
+        }
+        time = current_time;
+    }
+    return true;
+}
+
+void MeshCache::refresh_times(const std::filesystem::path& path, const std::vector<std::pair<uint64_t, int64_t>>& times) {
+    std::fstream stream{path, std::ios::binary | std::ios::in | std::ios::out};
+    for (const auto& [offset, time] : times) {
+        stream.seekp(static_cast<std::streamoff>(offset));
+        stream.write(reinterpret_cast<const char*>(&time), sizeof(time));
+    }
+
+    // The cache stays valid even if the times could not be written, the files are just hashed again next time.
+    if (!stream.good()) {
+        std::cerr << "Could not refresh mesh cache " << path.generic_string() << std::endl;
+    }
+}
+
+bool MeshCache::is_consistent() const {
+    const Header& header = this->header();
+
+    const bool sections_fit =
+        header.elements_per_vertex == MeshData::ELEMENTS_PER_VERTEX
+        && (header.index_type == GL_UNSIGNED_SHORT || header.index_type == GL_UNSIGNED_INT)
+        && header.vertices_offset >= sizeof(Header)
+        && header.vertices_offset + uint64_t{header.vertices_count} * header.elements_per_vertex * sizeof(float)
+               <= header.indices_offset
+        && header.indices_offset + uint64_t{header.indices_count} * index_size(header.index_type)
+               <= header.submeshes_offset
+        && header.submeshes_offset + uint64_t{header.submeshes_count} * sizeof(Submesh) <= header.materials_offset
+        && header.materials_offset + uint64_t{header.materials_count} * sizeof(MaterialRecord)
+               <= header.dependencies_offset
+        && header.dependencies_offset + uint64_t{header.dependencies_count} * sizeof(DependencyRecord)
+               <= header.strings_offset
+        && header.strings_offset + header.strings_size <= file.size();
+    if (!sections_fit) {
+        return false;
+    }
+
+    // The submeshes and the material strings must not point outside of their sections.
+    const Submesh* submeshes = reinterpret_cast<const Submesh*>(file.data() + header.submeshes_offset);
+    for (uint32_t s = 0; s < header.submeshes_count; s++) {
+        if (uint64_t{submeshes[s].first_index} + submeshes[s].indices_count > header.indices_count
+            || submeshes[s].material_id >= static_cast<int64_t>(header.materials_count)) {
+            return false;
+        }
+    }
+
+    const MaterialRecord* records = reinterpret_cast<const MaterialRecord*>(file.data() + header.materials_offset);
+    for (uint32_t m = 0; m < header.materials_count; m++) {
+        if (uint64_t{records[m].name_offset} + records[m].name_size > header.strings_size
+            || uint64_t{records[m].texture_offset} + records[m].texture_size > header.strings_size) {
+            return false;
+        }
+    }
+
+    const DependencyRecord* dependencies = reinterpret_cast<const DependencyRecord*>(file.data() + header.dependencies_offset);
+    for (uint32_t d = 0; d < header.dependencies_count; d++) {
+        if (uint64_t{dependencies[d].path_offset} + dependencies[d].path_size > header.strings_size) {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,172 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "mip_chain.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIP_CHAIN_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+    /** The precision of the linear values the levels are filtered in, 4 values still fit into 16 bits. */
+    const int linear_bits = 14;
+    const int linear_max = (1 << linear_bits) - 1;
+
+    /** The conversion tables between the 8-bit and the 14-bit linear values. */
+    struct Tables {
+        std::array<uint16_t, 256> decode_srgb;
+        std::array<uint16_t, 256> decode_linear;
+        std::array<uint8_t, linear_max + 1> encode_srgb;
+        std::array<uint8_t, linear_max + 1> encode_linear;
+    };
+
+    const Tables& tables() {
+        static const Tables tables = []() {
+            Tables result;
+            for (int i = 0; i < 256; i++) {
+                const double value = i / 255.0;
+                const double linear = value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+                result.decode_srgb[i] = static_cast<uint16_t>(std::lround(linear * linear_max));
+                result.decode_linear[i] = static_cast<uint16_t>(std::lround(value * linear_max));
+            }
+            for (int i = 0; i <= linear_max; i++) {
+                const double linear = double(i) / linear_max;
+                const double srgb = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+                result.encode_srgb[i] = static_cast<uint8_t>(std::lround(std::clamp(srgb, 0.0, 1.0) * 255.0));
+                result.encode_linear[i] = static_cast<uint8_t>(std::lround(linear * 255.0));
+            }
+            return result;
+        }();
+        return tables;
+    }
+
+    /** Converts a row of RGBA8 pixels into the linear values. */
+    void decode_row(const unsigned char* source, int width, uint16_t* target, bool gamma_correct) {
+        const Tables& t = tables();
+        const std::array<uint16_t, 256>& decode_color = gamma_correct ? t.decode_srgb : t.decode_linear;
+        for (int i = 0; i < width * 4; i += 4) {
+            target[i + 0] = decode_color[source[i + 0]];
+            target[i + 1] = decode_color[source[i + 1]];
+            target[i + 2] = decode_color[source[i + 2]];
+            target[i + 3] = t.decode_linear[source[i + 3]];
+        }
+    }
+
+    /** Converts the linear values into RGBA8 pixels. */
+    void encode(const uint16_t* source, size_t pixels_count, unsigned char* target, bool gamma_correct) {
+        const Tables& t = tables();
+        const std::array<uint8_t, linear_max + 1>& encode_color = gamma_correct ? t.encode_srgb : t.encode_linear;
+        for (size_t i = 0; i < pixels_count * 4; i += 4) {
+            target[i + 0] = encode_color[source[i + 0]];
+            target[i + 1] = encode_color[source[i + 1]];
+            target[i + 2] = encode_color[source[i + 2]];
+            target[i + 3] = t.encode_linear[source[i + 3]];
+        }
+    }
+
+    /**
+     * Averages 2x2 blocks of two source rows into a single target row. Sources that are only 1 pixel wide use the same
+     * pixel twice.
+     */
+    void downsample_row(const uint16_t* row0, const uint16_t* row1, int source_width, uint16_t* target, int target_width,
+                        MipKernel kernel) {
+        int x = 0;
+
+#ifdef MIP_CHAIN_SSE2
+        if (kernel == MipKernel::SIMD && source_width >= 2) {
+            // Every register holds two RGBA pixels, two registers per row produce two target pixels.
+            const __m128i rounding = _mm_set1_epi16(2);
+            for (; x + 2 <= target_width; x += 2) {
+                const __m128i sum0 = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8 * x)),
+                                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8 * x)));
+                const __m128i sum1 = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8 * x + 8)),
+                                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8 * x + 8)));
+                const __m128i block0 = _mm_add_epi16(sum0, _mm_srli_si128(sum0, 8));
+                const __m128i block1 = _mm_add_epi16(sum1, _mm_srli_si128(sum1, 8));
+                const __m128i average = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(block0, block1), rounding), 2);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(target + 4 * x), average);
+            }
+        }
+#else
+        (void)kernel;
+#endif
+
+        for (; x < target_width; x++) {
+            const int x0 = 2 * x;
+            const int x1 = std::min(2 * x + 1, source_width - 1);
+            for (int c = 0; c < 4; c++) {
+                const int sum = row0[4 * x0 + c] + row0[4 * x1 + c] + row1[4 * x0 + c] + row1[4 * x1 + c];
+                target[4 * x + c] = static_cast<uint16_t>((sum + 2) >> 2);
+            }
+        }
+    }
+} // namespace
+
+MipChain build_mip_chain(int width, int height, const unsigned char* rgba, bool gamma_correct, MipKernel kernel) {
+    MipChain chain;
+    if (width <= 0 || height <= 0 || !rgba) {
+        return chain;
+    }
+
+    // Computes the placement of all levels.
+    size_t size = 0;
+    for (int level_width = width, level_height = height;; level_width = std::max(1, level_width / 2),
+             level_height = std::max(1, level_height / 2)) {
+        chain.levels.push_back({level_width, level_height, size});
+        size += size_t(level_width) * size_t(level_height) * 4;
+        if (level_width == 1 && level_height == 1) {
+            break;
+        }
+    }
+    chain.pixels.resize(size);
+
+    // The first level is the original image.
+    std::memcpy(chain.pixels.data(), rgba, size_t(width) * size_t(height) * 4);
+
+    // The original image is decoded row by row, the smaller levels are kept in the linear values.
+    std::vector<uint16_t> previous;
+    std::vector<uint16_t> current;
+    std::vector<uint16_t> decoded_rows(size_t(width) * 4 * 2);
+
+    for (size_t level = 1; level < chain.levels.size(); level++) {
+        const MipChain::Level& source = chain.levels[level - 1];
+        const MipChain::Level& target = chain.levels[level];
+        current.resize(size_t(target.width) * size_t(target.height) * 4);
+
+        for (int y = 0; y < target.height; y++) {
+            const int y0 = 2 * y;
+            const int y1 = std::min(2 * y + 1, source.height - 1);
+
+            const uint16_t* row0;
+            const uint16_t* row1;
+            if (level == 1) {
+                decode_row(rgba + size_t(y0) * width * 4, width, decoded_rows.data(), gamma_correct);
+                decode_row(rgba + size_t(y1) * width * 4, width, decoded_rows.data() + size_t(width) * 4, gamma_correct);
+                row0 = decoded_rows.data();
+                row1 = decoded_rows.data() + size_t(width) * 4;
+            } else {
+                row0 = previous.data() + size_t(y0) * source.width * 4;
+                row1 = previous.data() + size_t(y1) * source.width * 4;
+            }
+
+            downsample_row(row0, row1, source.width, current.data() + size_t(y) * target.width * 4, target.width,
+                           kernel);
+        }
+
+        encode(current.data(), size_t(target.width) * target.height, chain.pixels.data() + target.offset, gamma_correct);
+        std::swap(previous, current);
+    }
+
+    return chain;
+}
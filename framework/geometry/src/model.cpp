@@ -0,0 +1,349 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "model.hpp"
+#include "code_utils.h"
+#include "glm/common.hpp"
+#include "mesh_cache.hpp"
+#include "obj_parser.hpp"
+#include "tiny_obj_loader.h"
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <unordered_map>
+
+namespace {
+    /** Hashes the position/normal/texture coordinate triple referencing a single OBJ vertex. */
+    struct IndexHash {
+        std::size_t operator()(const tinyobj::index_t& index) const {
+            std::size_t seed = 0;
+            CodeUtils::hash_combine(seed, index.vertex_index);
+            CodeUtils::hash_combine(seed, index.normal_index);
+            CodeUtils::hash_combine(seed, index.texcoord_index);
+            return seed;
+        }
+    };
+
+    /** Compares two position/normal/texture coordinate triples. */
+    struct IndexEqual {
+        bool operator()(const tinyobj::index_t& first, const tinyobj::index_t& second) const {
+            return first.vertex_index == second.vertex_index && first.normal_index == second.normal_index
+                   && first.texcoord_index == second.texcoord_index;
+        }
+    };
+
+    /**
+     * Loads the materials with the specified names from the material libraries referenced by an OBJ file. Materials
+     * that are not found in any library get the default values.
+     *
+     * @param 	directory	The directory of the OBJ file, the libraries and the textures are relative to it.
+     * @param 	libraries	The names of the material libraries.
+     * @param 	names	 	The names of the used materials.
+     * @return	The materials in the order of the names.
+     */
+    std::vector<Material> load_materials(const std::filesystem::path& directory, const std::vector<std::string>& libraries,
+                                         const std::vector<std::string>& names) {
+        std::map<std::string, int> material_map;
+        std::vector<tinyobj::material_t> library_materials;
+        for (const std::string& library : libraries) {
+            std::ifstream stream(directory / library);
+            if (!stream.is_open()) {
+                std::cerr << "Material library " << (directory / library).generic_string() << " not found" << std::endl;
+                continue;
+            }
+
+            std::string warning, error;
+            tinyobj::LoadMtl(&material_map, &library_materials, &stream, &warning, &error);
+            if (!error.empty()) {
+                std::cerr << "TinyObjReader: " << error;
+            }
+        }
+
+        std::vector<Material> materials;
+        for (const std::string& name : names) {
+            Material& material = materials.emplace_back();
+            material.name = name;
+
+            const auto it = material_map.find(name);
+            if (it == material_map.end()) {
+                continue;
+            }
+
+            const tinyobj::material_t& source = library_materials[it->second];
+            material.ambient = glm::vec3(source.ambient[0], source.ambient[1], source.ambient[2]);
+            material.diffuse = glm::vec3(source.diffuse[0], source.diffuse[1], source.diffuse[2]);
+            material.specular = glm::vec3(source.specular[0], source.specular[1], source.specular[2]);
+            material.shininess = source.shininess;
+            if (!source.diffuse_texname.empty()) {
+                material.diffuse_texture = directory / source.diffuse_texname;
+            }
+        }
+
+        return materials;
+    }
+
+    /**
+     * Imports all shapes and materials of the specified OBJ file. The model is centered and scaled to fit into a unit
+     * cube.
+     *
+     * @param 	path		 	The path to the OBJ file.
+     * @param 	threads_count	The maximum number of threads parsing the file (0 to use all hardware threads).
+     * @return	The imported mesh (empty if the file could not be loaded).
+     */
+    MeshData import_obj(const std::filesystem::path& path, unsigned int threads_count = 0) {
+        const ObjParser::Result obj = ObjParser::parse(path, threads_count);
+
+        if (!obj.valid) {
+            std::cerr << "ObjParser: " << obj.warning;
+        } else if (!obj.warning.empty()) {
+            std::cout << "ObjParser: " << obj.warning;
+        }
+
+        if (obj.shapes.empty()) {
+            return {};
+        }
+
+        // Each unique position/normal/texture coordinate triple becomes a single vertex referenced by the index buffer.
+        const int elements_per_vertex = MeshData::ELEMENTS_PER_VERTEX;
+        MeshData mesh;
+        std::vector<float>& vertices = mesh.vertices;
+        std::vector<uint32_t>& indices = mesh.indices;
+        std::unordered_map<tinyobj::index_t, uint32_t, IndexHash, IndexEqual> unique_vertices;
+
+        indices.reserve(obj.indices.size());
+        unique_vertices.reserve(obj.indices.size());
+
+        glm::vec3 min{std::numeric_limits<float>::max()};
+        glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+        const int positions_count = static_cast<int>(obj.vertices.size() / 3);
+        const int normals_count = static_cast<int>(obj.normals.size() / 3);
+        const int texcoords_count = static_cast<int>(obj.texcoords.size() / 2);
+
+        // Assigns the materials their indices in the order of their first use.
+        std::vector<std::string> material_names;
+        std::unordered_map<std::string, int32_t> material_ids;
+
+        // Loop over shapes
+        for (const ObjParser::Shape& shape : obj.shapes) {
+            int32_t material_id = -1;
+            if (!shape.material.empty()) {
+                const auto [it, inserted] = material_ids.try_emplace(shape.material, static_cast<int32_t>(material_names.size()));
+                if (inserted) {
+                    material_names.push_back(shape.material);
+                }
+                material_id = it->second;
+            }
+
+            const uint32_t first_index = static_cast<uint32_t>(indices.size());
+
+            // Loop over triangles
+            for (size_t t = shape.first_index; t < shape.first_index + shape.indices_count; t += 3) {
+                // Skip triangles referencing missing positions
+                bool valid = true;
+                for (size_t v = 0; v < 3; v++) {
+                    const int vertex_index = obj.indices[t + v].vertex_index;
+                    valid = valid && vertex_index >= 0 && vertex_index < positions_count;
+                }
+                if (!valid) {
+                    continue;
+                }
+
+                // Loop over vertices in the triangle.
+                for (size_t v = 0; v < 3; v++) {
+                    // Access to vertex
+                    tinyobj::index_t idx = obj.indices[t + v];
+
+                    const auto [it, inserted] = unique_vertices.try_emplace(idx, static_cast<uint32_t>(unique_vertices.size()));
+                    indices.push_back(it->second);
+
+                    if (!inserted) {
+                        continue;
+                    }
+
+                    float vx = obj.vertices[3 * idx.vertex_index + 0];
+                    float vy = obj.vertices[3 * idx.vertex_index + 1];
+                    float vz = obj.vertices[3 * idx.vertex_index + 2];
+
+                    float nx = 0.0f;
+                    float ny = 0.0f;
+                    float nz = 0.0f;
+                    if (idx.normal_index >= 0 && idx.normal_index < normals_count) {
+                        nx = obj.normals[3 * idx.normal_index + 0];
+                        ny = obj.normals[3 * idx.normal_index + 1];
+                        nz = obj.normals[3 * idx.normal_index + 2];
+                    }
+
+                    float tx = 0.0f;
+                    float ty = 0.0f;
+                    if (idx.texcoord_index >= 0 && idx.texcoord_index < texcoords_count) {
+                        tx = obj.texcoords[2 * idx.texcoord_index + 0];
+                        ty = obj.texcoords[2 * idx.texcoord_index + 1];
+                    }
+
+                    min = glm::min(min, glm::vec3(vx, vy, vz));
+                    max = glm::max(max, glm::vec3(vx, vy, vz));
+
+                    vertices.insert(vertices.end(), {vx, vy, vz, nx, ny, nz, tx, ty});
+                }
+            }
+
+            // Consecutive shapes with the same material are drawn together.
+            const uint32_t indices_count = static_cast<uint32_t>(indices.size()) - first_index;
+            if (indices_count == 0) {
+                continue;
+            }
+            if (!mesh.submeshes.empty() && mesh.submeshes.back().material_id == material_id) {
+                mesh.submeshes.back().indices_count += indices_count;
+            } else {
+                mesh.submeshes.push_back({first_index, indices_count, material_id});
+            }
+        }
+
+        if (vertices.empty()) {
+            return {};
+        }
+
+        mesh.materials = load_materials(path.parent_path(), obj.material_libraries, material_names);
+        for (const std::string& library : obj.material_libraries) {
+            mesh.material_libraries.push_back(path.parent_path() / library);
+        }
+
+        // Centers the model and scales it to fit into a unit cube.
+        const glm::vec3 diff = max - min;
+        const glm::vec3 center = min + 0.5f * diff;
+        const float scale = std::max(std::max(diff.x, diff.y), diff.z);
+        for (size_t i = 0; i < vertices.size(); i += elements_per_vertex) {
+            vertices[i + 0] = (vertices[i + 0] - center.x) / scale;
+            vertices[i + 1] = (vertices[i + 1] - center.y) / scale;
+            vertices[i + 2] = (vertices[i + 2] - center.z) / scale;
+        }
+
+        mesh.center = center;
+        mesh.scale = scale;
+        mesh.aabb_min = (min - center) / scale;
+        mesh.aabb_max = (max - center) / scale;
+
+        return mesh;
+    }
+
+    /** Creates the geometry directly from the memory-mapped cache. */
+    Geometry create_cache_geometry(const MeshCache& cache) {
+        const MeshCache::Header& header = cache.header();
+        return Geometry{GL_TRIANGLES, static_cast<int>(header.elements_per_vertex), static_cast<int>(header.vertices_count),
+                        cache.vertices(), static_cast<int>(header.indices_count), cache.indices(), header.index_type,
+                        Geometry::DEFAULT_POSITION_LOC, Geometry::DEFAULT_NORMAL_LOC, Geometry::DEFAULT_TEX_COORD_LOC,
+                        -1, -1, -1};
+    }
+} // namespace
+
+// ----------------------------------------------------------------------------
+// Methods of LoadedMesh
+// ----------------------------------------------------------------------------
+
+size_t LoadedMesh::size() const {
+    if (cache) {
+        const MeshCache::Header& header = cache->header();
+        return size_t{header.vertices_count} * header.elements_per_vertex * sizeof(float)
+               + size_t{header.indices_count} * (header.index_type == GL_UNSIGNED_SHORT ? 2 : 4);
+    }
+    return mesh.vertices.size() * sizeof(float) + mesh.indices.size() * (mesh.index_type() == GL_UNSIGNED_SHORT ? 2 : 4);
+}
+
+Geometry LoadedMesh::create_geometry() const { return cache ? create_cache_geometry(*cache) : Geometry{mesh}; }
+
+// ----------------------------------------------------------------------------
+// Constructors
+// ----------------------------------------------------------------------------
+
+Model::Model(Geometry geometry, std::vector<Submesh> submeshes, std::vector<Material> materials)
+    : geometry(std::move(geometry)), submeshes(std::move(submeshes)), materials(std::move(materials)) {
+    init_draws();
+}
+
+Model::Model(const MeshData& mesh)
+    : geometry(mesh), submeshes(mesh.submeshes), materials(mesh.materials), aabb_min(mesh.aabb_min),
+      aabb_max(mesh.aabb_max) {
+    init_draws();
+}
+
+// ----------------------------------------------------------------------------
+// Methods
+// ----------------------------------------------------------------------------
+
+Model Model::from_file(const std::filesystem::path& path) {
+    const std::string extension = path.extension().generic_string();
+
+    if (extension == ".obj") {
+        // Uploads the memory-mapped cache directly if the model was already imported.
+        if (const std::optional<MeshCache> cache = MeshCache::load(path)) {
+            const MeshCache::Header& header = cache->header();
+            Model model{create_cache_geometry(*cache), cache->submeshes(), cache->materials()};
+            model.aabb_min = glm::vec3(header.aabb_min[0], header.aabb_min[1], header.aabb_min[2]);
+            model.aabb_max = glm::vec3(header.aabb_max[0], header.aabb_max[1], header.aabb_max[2]);
+            return model;
+        }
+
+        const MeshData mesh = import_obj(path);
+        if (mesh.vertices.empty()) {
+            return Model{};
+        }
+
+        std::cout << "Model: " << path.filename().generic_string() << " - " << mesh.vertices_count()
+                  << " unique vertices, " << mesh.indices_count() << " emitted, " << mesh.submeshes.size()
+                  << " submeshes, " << mesh.materials.size() << " materials" << std::endl;
+
+        MeshCache::store(path, mesh);
+
+        return Model{mesh};
+    }
+    std::cerr << "Extension " << extension << " not supported" << std::endl;
+
+    return Model{};
+}
+
+LoadedMesh Model::load_mesh(const std::filesystem::path& path, unsigned int threads_count) {
+    if (path.extension() != ".obj") {
+        std::cerr << "Extension " << path.extension().generic_string() << " not supported" << std::endl;
+        return {};
+    }
+
+    LoadedMesh loaded;
+    loaded.cache = MeshCache::load(path);
+    if (!loaded.cache) {
+        loaded.mesh = import_obj(path, threads_count);
+        if (!loaded.mesh.vertices.empty()) {
+            MeshCache::store(path, loaded.mesh);
+        }
+    }
+    return loaded;
+}
+
+void Model::draw_submesh(size_t submesh) const {
+    glDrawElements(geometry.mode, draw_counts[submesh], geometry.index_type, draw_offsets[submesh]);
+}
+
+void Model::draw() const {
+    bind_vao();
+    glMultiDrawElements(geometry.mode, draw_counts.data(), geometry.index_type, draw_offsets.data(),
+                        static_cast<GLsizei>(draw_counts.size()));
+}
+
+void Model::init_draws() {
+    // Geometries without any submesh are drawn as a single submesh without a material.
+    if (submeshes.empty() && geometry.draw_elements_count > 0) {
+        submeshes.push_back({0, static_cast<uint32_t>(geometry.draw_elements_count), -1});
+    }
+
+    draw_counts.clear();
+    draw_offsets.clear();
+    for (const Submesh& submesh : submeshes) {
+        draw_counts.push_back(static_cast<GLsizei>(submesh.indices_count));
+        draw_offsets.push_back(reinterpret_cast<const void*>(uintptr_t{submesh.first_index} * geometry.index_size()));
+    }
+}
@@ -0,0 +1,528 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "obj_parser.hpp"
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+namespace {
+    /** The minimum size of a chunk (in bytes), smaller files are not worth splitting. */
+    const size_t min_chunk_size = 256 * 1024;
+
+    /** The corner of a face as written in the file, the indices are zero-based and -1 if missing. */
+    struct Corner {
+        int v = -1;
+        int vt = -1;
+        int vn = -1;
+    };
+
+    /** The change of the object/group name or of the material before the specified face of a chunk. */
+    struct Event {
+        size_t face;
+        bool is_material;
+        std::string value;
+    };
+
+    /** The part of the file parsed by a single thread. */
+    struct Chunk {
+        const char* begin;
+        const char* end;
+
+        std::vector<float> vertices;
+        std::vector<float> normals;
+        std::vector<float> texcoords;
+
+        /** The corners of all faces, the faces are stored one after another. */
+        std::vector<Corner> corners;
+        /** The number of corners of every face. */
+        std::vector<uint32_t> face_sizes;
+        /** The corners with relative indices that have to be offset by the counts of the preceding chunks. */
+        std::vector<size_t> relative_vertices;
+        std::vector<size_t> relative_texcoords;
+        std::vector<size_t> relative_normals;
+
+        std::vector<Event> events;
+        std::vector<std::string> material_libraries;
+
+        /** The triangulated faces and the offset of the first triangle index of every face. */
+        std::vector<tinyobj::index_t> indices;
+        std::vector<size_t> face_offsets;
+
+        std::string warning;
+    };
+
+    /** Runs the function on every chunk, each on its own thread. */
+    template <typename Function> void for_each_chunk(std::vector<Chunk>& chunks, Function function) {
+        if (chunks.size() == 1) {
+            function(chunks[0]);
+            return;
+        }
+
+        std::vector<std::thread> threads;
+        threads.reserve(chunks.size());
+        for (Chunk& chunk : chunks) {
+            threads.emplace_back([&function, &chunk]() { function(chunk); });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    bool is_space(char c) { return c == ' ' || c == '\t'; }
+
+    const char* skip_spaces(const char* it, const char* end) {
+        while (it < end && is_space(*it)) {
+            it++;
+        }
+        return it;
+    }
+
+    /** Parses a float, the value is set to zero if the text is not a number (consistently with tinyobjloader). */
+    const char* parse_float(const char* it, const char* end, float& value) {
+        it = skip_spaces(it, end);
+        if (it < end && *it == '+') {
+            it++;
+        }
+
+        // The number is parsed in double precision and rounded afterwards the same way tinyobjloader does it.
+        double parsed = 0.0;
+        const auto [ptr, error] = std::from_chars(it, end, parsed);
+        value = error == std::errc{} ? static_cast<float>(parsed) : 0.0f;
+        return error == std::errc{} ? ptr : it;
+    }
+
+    /** Returns the rest of the line without the leading and trailing white spaces. */
+    std::string parse_name(const char* it, const char* end) {
+        it = skip_spaces(it, end);
+        while (end > it && is_space(end[-1])) {
+            end--;
+        }
+        return std::string(it, end);
+    }
+
+    /**
+     * Parses the index of a face corner. Positive indices are converted to zero-based, negative (relative) indices are
+     * converted relatively to the number of elements in the chunk and remembered so that they can be fixed once the
+     * number of elements in the preceding chunks is known.
+     */
+    bool parse_index(const char*& it, const char* end, int& index, size_t count, size_t corner,
+                     std::vector<size_t>& relative) {
+        int value = 0;
+        const auto [ptr, error] = std::from_chars(it, end, value);
+        if (error != std::errc{} || value == 0) {
+            return false;
+        }
+
+        it = ptr;
+        if (value > 0) {
+            index = value - 1;
+        } else {
+            index = static_cast<int>(count) + value;
+            relative.push_back(corner);
+        }
+        return true;
+    }
+
+    /** Parses a single 'f' record. */
+    void parse_face(const char* it, const char* end, Chunk& chunk) {
+        const size_t first = chunk.corners.size();
+        const size_t relative_vertices = chunk.relative_vertices.size();
+        const size_t relative_texcoords = chunk.relative_texcoords.size();
+        const size_t relative_normals = chunk.relative_normals.size();
+
+        bool valid = true;
+        while (valid) {
+            it = skip_spaces(it, end);
+            if (it == end) {
+                break;
+            }
+
+            const size_t index = chunk.corners.size();
+            Corner& corner = chunk.corners.emplace_back();
+            valid = parse_index(it, end, corner.v, chunk.vertices.size() / 3, index, chunk.relative_vertices);
+            if (valid && it < end && *it == '/') {
+                it++;
+                if (it < end && *it != '/' && !is_space(*it)) {
+                    valid = parse_index(it, end, corner.vt, chunk.texcoords.size() / 2, index,
+                                        chunk.relative_texcoords);
+                }
+                if (valid && it < end && *it == '/') {
+                    it++;
+                    valid = parse_index(it, end, corner.vn, chunk.normals.size() / 3, index, chunk.relative_normals);
+                }
+            }
+            valid = valid && (it == end || is_space(*it));
+        }
+
+        const size_t count = chunk.corners.size() - first;
+        if (!valid || count < 3) {
+            // Drops the corners of the invalid face together with their relative indices.
+            chunk.corners.resize(first);
+            chunk.relative_vertices.resize(relative_vertices);
+            chunk.relative_texcoords.resize(relative_texcoords);
+            chunk.relative_normals.resize(relative_normals);
+            if (!valid) {
+                chunk.warning += "Failed to parse a face: " + std::string(it, end) + "\n";
+            }
+            return;
+        }
+
+        chunk.face_sizes.push_back(static_cast<uint32_t>(count));
+    }
+
+    /** Parses all lines of the chunk. */
+    void parse_chunk(Chunk& chunk) {
+        const char* line = chunk.begin;
+        while (line < chunk.end) {
+            const char* line_end = static_cast<const char*>(std::memchr(line, '\n', chunk.end - line));
+            const char* next = line_end ? line_end + 1 : chunk.end;
+            if (!line_end) {
+                line_end = chunk.end;
+            }
+            if (line_end > line && line_end[-1] == '\r') {
+                line_end--;
+            }
+
+            const char* it = skip_spaces(line, line_end);
+            const size_t length = line_end - it;
+
+            if (length >= 2 && it[0] == 'v' && is_space(it[1])) {
+                float x, y, z;
+                it = parse_float(it + 2, line_end, x);
+                it = parse_float(it, line_end, y);
+                parse_float(it, line_end, z);
+                chunk.vertices.insert(chunk.vertices.end(), {x, y, z});
+            } else if (length >= 3 && it[0] == 'v' && it[1] == 'n' && is_space(it[2])) {
+                float x, y, z;
+                it = parse_float(it + 3, line_end, x);
+                it = parse_float(it, line_end, y);
+                parse_float(it, line_end, z);
+                chunk.normals.insert(chunk.normals.end(), {x, y, z});
+            } else if (length >= 3 && it[0] == 'v' && it[1] == 't' && is_space(it[2])) {
+                float u, v;
+                it = parse_float(it + 3, line_end, u);
+                parse_float(it, line_end, v);
+                chunk.texcoords.insert(chunk.texcoords.end(), {u, v});
+            } else if (length >= 2 && it[0] == 'f' && is_space(it[1])) {
+                parse_face(it + 2, line_end, chunk);
+            } else if (length >= 1 && (it[0] == 'o' || it[0] == 'g') && (length == 1 || is_space(it[1]))) {
+                chunk.events.push_back({chunk.face_sizes.size(), false, parse_name(it + 1, line_end)});
+            } else if (length >= 7 && std::strncmp(it, "usemtl", 6) == 0 && is_space(it[6])) {
+                chunk.events.push_back({chunk.face_sizes.size(), true, parse_name(it + 7, line_end)});
+            } else if (length >= 7 && std::strncmp(it, "mtllib", 6) == 0 && is_space(it[6])) {
+                const char* name = skip_spaces(it + 7, line_end);
+                while (name < line_end) {
+                    const char* name_end = name;
+                    while (name_end < line_end && !is_space(*name_end)) {
+                        name_end++;
+                    }
+                    chunk.material_libraries.emplace_back(name, name_end);
+                    name = skip_spaces(name_end, line_end);
+                }
+            }
+
+            line = next;
+        }
+    }
+
+    /** Checks whether the point lies inside the polygon (the same test as used by tinyobjloader). */
+    bool point_in_polygon(int count, const float* xs, const float* ys, float x, float y) {
+        bool inside = false;
+        for (int i = 0, j = count - 1; i < count; j = i++) {
+            if (((ys[i] > y) != (ys[j] > y)) && (x < (xs[j] - xs[i]) * (y - ys[i]) / (ys[j] - ys[i]) + xs[i])) {
+                inside = !inside;
+            }
+        }
+        return inside;
+    }
+
+    /**
+     * Triangulates a single face. The algorithm mirrors tinyobjloader: quads are split along the shorter diagonal and
+     * larger polygons are ear-clipped in the plane given by the two most significant axes.
+     */
+    void triangulate(const Corner* face, size_t count, const std::vector<float>& vertices,
+                     std::vector<tinyobj::index_t>& indices, std::string& warning) {
+        const auto emit = [&indices](const Corner& corner) { indices.push_back({corner.v, corner.vn, corner.vt}); };
+        const size_t vertices_size = vertices.size();
+
+        if (count == 3) {
+            emit(face[0]);
+            emit(face[1]);
+            emit(face[2]);
+            return;
+        }
+
+        if (count == 4) {
+            for (size_t i = 0; i < 4; i++) {
+                if (face[i].v < 0 || size_t(face[i].v) * 3 + 2 >= vertices_size) {
+                    warning += "Face with invalid vertex index found.\n";
+                    return;
+                }
+            }
+
+            const float* v0 = &vertices[size_t(face[0].v) * 3];
+            const float* v1 = &vertices[size_t(face[1].v) * 3];
+            const float* v2 = &vertices[size_t(face[2].v) * 3];
+            const float* v3 = &vertices[size_t(face[3].v) * 3];
+
+            const float e02x = v2[0] - v0[0], e02y = v2[1] - v0[1], e02z = v2[2] - v0[2];
+            const float e13x = v3[0] - v1[0], e13y = v3[1] - v1[1], e13z = v3[2] - v1[2];
+            const float sqr02 = e02x * e02x + e02y * e02y + e02z * e02z;
+            const float sqr13 = e13x * e13x + e13y * e13y + e13z * e13z;
+
+            if (sqr02 < sqr13) {
+                // [0, 1, 2], [0, 2, 3]
+                for (const size_t i : {0, 1, 2, 0, 2, 3}) {
+                    emit(face[i]);
+                }
+            } else {
+                // [0, 1, 3], [1, 2, 3]
+                for (const size_t i : {0, 1, 3, 1, 2, 3}) {
+                    emit(face[i]);
+                }
+            }
+            return;
+        }
+
+        // Finds the two axes of the plane in which the polygon is ear-clipped.
+        size_t axes[2] = {1, 2};
+        for (size_t k = 0; k < count; k++) {
+            const size_t vi0 = size_t(face[k % count].v);
+            const size_t vi1 = size_t(face[(k + 1) % count].v);
+            const size_t vi2 = size_t(face[(k + 2) % count].v);
+            if (3 * vi0 + 2 >= vertices_size || 3 * vi1 + 2 >= vertices_size || 3 * vi2 + 2 >= vertices_size) {
+                continue;
+            }
+
+            const float e0x = vertices[vi1 * 3 + 0] - vertices[vi0 * 3 + 0];
+            const float e0y = vertices[vi1 * 3 + 1] - vertices[vi0 * 3 + 1];
+            const float e0z = vertices[vi1 * 3 + 2] - vertices[vi0 * 3 + 2];
+            const float e1x = vertices[vi2 * 3 + 0] - vertices[vi1 * 3 + 0];
+            const float e1y = vertices[vi2 * 3 + 1] - vertices[vi1 * 3 + 1];
+            const float e1z = vertices[vi2 * 3 + 2] - vertices[vi1 * 3 + 2];
+            const float cx = std::fabs(e0y * e1z - e0z * e1y);
+            const float cy = std::fabs(e0z * e1x - e0x * e1z);
+            const float cz = std::fabs(e0x * e1y - e0y * e1x);
+
+            const float epsilon = std::numeric_limits<float>::epsilon();
+            if (cx > epsilon || cy > epsilon || cz > epsilon) {
+                if (!(cx > cy && cx > cz)) {
+                    axes[0] = 0;
+                    if (cz > cx && cz > cy) {
+                        axes[1] = 1;
+                    }
+                }
+                break;
+            }
+        }
+
+        std::vector<Corner> remaining(face, face + count);
+        size_t guess_vertex = 0;
+        size_t remaining_iterations = count;
+        size_t previous_remaining = count;
+
+        while (remaining.size() > 3 && remaining_iterations > 0) {
+            const size_t polygon_size = remaining.size();
+            if (guess_vertex >= polygon_size) {
+                guess_vertex -= polygon_size;
+            }
+
+            if (previous_remaining != polygon_size) {
+                // The polygon shrank, so all vertices are tried again.
+                previous_remaining = polygon_size;
+                remaining_iterations = polygon_size;
+            } else {
+                remaining_iterations--;
+            }
+
+            Corner ear[3];
+            float xs[3], ys[3];
+            for (size_t k = 0; k < 3; k++) {
+                ear[k] = remaining[(guess_vertex + k) % polygon_size];
+                const size_t vi = size_t(ear[k].v);
+                if (vi * 3 + axes[0] >= vertices_size || vi * 3 + axes[1] >= vertices_size) {
+                    xs[k] = 0.0f;
+                    ys[k] = 0.0f;
+                } else {
+                    xs[k] = vertices[vi * 3 + axes[0]];
+                    ys[k] = vertices[vi * 3 + axes[1]];
+                }
+            }
+
+            // Skips reflex vertices.
+            const float e0x = xs[1] - xs[0], e0y = ys[1] - ys[0];
+            const float e1x = xs[2] - xs[1], e1y = ys[2] - ys[1];
+            const float cross = e0x * e1y - e0y * e1x;
+            const float area = (xs[0] * ys[1] - ys[0] * xs[1]) * 0.5f;
+            if (cross * area < 0.0f) {
+                guess_vertex++;
+                continue;
+            }
+
+            // Skips ears containing other vertices.
+            bool overlap = false;
+            for (size_t other = 3; other < polygon_size; other++) {
+                const size_t vi = size_t(remaining[(guess_vertex + other) % polygon_size].v);
+                if (vi * 3 + axes[0] >= vertices_size || vi * 3 + axes[1] >= vertices_size) {
+                    continue;
+                }
+                if (point_in_polygon(3, xs, ys, vertices[vi * 3 + axes[0]], vertices[vi * 3 + axes[1]])) {
+                    overlap = true;
+                    break;
+                }
+            }
+            if (overlap) {
+                guess_vertex++;
+                continue;
+            }
+
+            emit(ear[0]);
+            emit(ear[1]);
+            emit(ear[2]);
+            remaining.erase(remaining.begin() + static_cast<std::ptrdiff_t>((guess_vertex + 1) % polygon_size));
+        }
+
+        if (remaining.size() == 3) {
+            emit(remaining[0]);
+            emit(remaining[1]);
+            emit(remaining[2]);
+        }
+    }
+
+    /** Triangulates all faces of the chunk. */
+    void triangulate_chunk(Chunk& chunk, const std::vector<float>& vertices) {
+        chunk.indices.reserve(chunk.corners.size() * 3 / 2);
+        chunk.face_offsets.reserve(chunk.face_sizes.size() + 1);
+
+        const Corner* face = chunk.corners.data();
+        for (const uint32_t face_size : chunk.face_sizes) {
+            chunk.face_offsets.push_back(chunk.indices.size());
+            triangulate(face, face_size, vertices, chunk.indices, chunk.warning);
+            face += face_size;
+        }
+        chunk.face_offsets.push_back(chunk.indices.size());
+    }
+} // namespace
+
+// ----------------------------------------------------------------------------
+// Methods
+// ----------------------------------------------------------------------------
+
+ObjParser::Result ObjParser::parse(const std::filesystem::path& path, unsigned int threads_count) {
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error)) {
+        Result result;
+        result.warning = "Could not open " + path.generic_string() + "\n";
+        return result;
+    }
+
+    // Empty files cannot be mapped, they are simply parsed as empty.
+    const MappedFile file{path};
+    return parse(file.data(), file.size(), threads_count);
+}
+
+ObjParser::Result ObjParser::parse(const char* data, size_t size, unsigned int threads_count) {
+    Result result;
+    result.valid = true;
+
+    // Splits the data into chunks at line boundaries.
+    if (threads_count == 0) {
+        threads_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const size_t chunks_count = std::clamp<size_t>(size / min_chunk_size, 1, threads_count);
+
+    std::vector<Chunk> chunks(chunks_count);
+    const char* begin = data;
+    const char* end = data + size;
+    for (size_t i = 0; i < chunks_count; i++) {
+        const char* chunk_end = i + 1 == chunks_count ? end : std::max(begin, data + size * (i + 1) / chunks_count);
+        while (chunk_end < end && chunk_end[-1] != '\n') {
+            chunk_end++;
+        }
+        chunks[i].begin = begin;
+        chunks[i].end = chunk_end;
+        begin = chunk_end;
+    }
+
+    for_each_chunk(chunks, parse_chunk);
+
+    // Resolves the relative indices and gathers the attributes at their final positions.
+    size_t vertices_size = 0, normals_size = 0, texcoords_size = 0;
+    std::vector<size_t> vertices_offsets, normals_offsets, texcoords_offsets;
+    for (const Chunk& chunk : chunks) {
+        vertices_offsets.push_back(vertices_size);
+        normals_offsets.push_back(normals_size);
+        texcoords_offsets.push_back(texcoords_size);
+        vertices_size += chunk.vertices.size();
+        normals_size += chunk.normals.size();
+        texcoords_size += chunk.texcoords.size();
+    }
+    result.vertices.resize(vertices_size);
+    result.normals.resize(normals_size);
+    result.texcoords.resize(texcoords_size);
+
+    for_each_chunk(chunks, [&](Chunk& chunk) {
+        const size_t i = &chunk - chunks.data();
+        std::copy(chunk.vertices.begin(), chunk.vertices.end(), result.vertices.begin() + vertices_offsets[i]);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), result.normals.begin() + normals_offsets[i]);
+        std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), result.texcoords.begin() + texcoords_offsets[i]);
+
+        for (const size_t corner : chunk.relative_vertices) {
+            chunk.corners[corner].v += static_cast<int>(vertices_offsets[i] / 3);
+        }
+        for (const size_t corner : chunk.relative_normals) {
+            chunk.corners[corner].vn += static_cast<int>(normals_offsets[i] / 3);
+        }
+        for (const size_t corner : chunk.relative_texcoords) {
+            chunk.corners[corner].vt += static_cast<int>(texcoords_offsets[i] / 2);
+        }
+    });
+
+    // The faces may reference the vertices of any chunk, so they are triangulated only once all of them are gathered.
+    for_each_chunk(chunks, [&result](Chunk& chunk) { triangulate_chunk(chunk, result.vertices); });
+
+    // Concatenates the triangles and splits them into shapes.
+    size_t indices_size = 0;
+    for (const Chunk& chunk : chunks) {
+        indices_size += chunk.indices.size();
+    }
+    result.indices.reserve(indices_size);
+
+    Shape shape;
+    const auto close_shape = [&result, &shape](size_t position) {
+        shape.indices_count = position - shape.first_index;
+        if (shape.indices_count > 0) {
+            result.shapes.push_back(shape);
+        }
+        shape.first_index = position;
+    };
+
+    for (const Chunk& chunk : chunks) {
+        const size_t base = result.indices.size();
+        for (const Event& event : chunk.events) {
+            const size_t position = base + chunk.face_offsets[event.face];
+            if (event.is_material && event.value == shape.material) {
+                continue;
+            }
+            close_shape(position);
+            (event.is_material ? shape.material : shape.name) = event.value;
+        }
+
+        result.indices.insert(result.indices.end(), chunk.indices.begin(), chunk.indices.end());
+        result.material_libraries.insert(result.material_libraries.end(), chunk.material_libraries.begin(),
+                                         chunk.material_libraries.end());
+        result.warning += chunk.warning;
+    }
+    close_shape(result.indices.size());
+
+    return result;
+}
@@ -0,0 +1,72 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "block_compression.hpp"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <vector>
+
+namespace {
+    const int image_size = 512;
+
+    /** Builds the mipmaps of a smooth image with some detail, optionally with a varying alpha channel. */
+    MipChain test_image(bool alpha) {
+        std::vector<unsigned char> pixels(size_t(image_size) * image_size * 4);
+        for (int y = 0; y < image_size; y++) {
+            for (int x = 0; x < image_size; x++) {
+                unsigned char* pixel = pixels.data() + (size_t(y) * image_size + x) * 4;
+                pixel[0] = static_cast<unsigned char>(x / 2);
+                pixel[1] = static_cast<unsigned char>(y / 2);
+                pixel[2] = static_cast<unsigned char>(127.5 + 127.5 * std::sin(0.05 * x) * std::cos(0.07 * y));
+                pixel[3] = alpha ? static_cast<unsigned char>((x + y) / 4) : 255;
+            }
+        }
+        return build_mip_chain(image_size, image_size, pixels.data());
+    }
+
+    /** The number of pixels in all levels of the image. */
+    int64_t pixels_count(const MipChain& image) { return int64_t(image.pixels.size() / 4); }
+} // namespace
+
+/** Compresses an opaque image into BC1, the argument selects the high quality refinement. */
+static void BM_CompressBC1(benchmark::State& state) {
+    const MipChain image = test_image(false);
+    const bool high_quality = state.range(0) != 0;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(compress_image(image, high_quality));
+    }
+    state.SetItemsProcessed(state.iterations() * pixels_count(image));
+    state.SetLabel("pixels");
+}
+BENCHMARK(BM_CompressBC1)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+/** Compresses an image with an alpha channel into BC3, the argument selects the high quality refinement. */
+static void BM_CompressBC3(benchmark::State& state) {
+    const MipChain image = test_image(true);
+    const bool high_quality = state.range(0) != 0;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(compress_image(image, high_quality));
+    }
+    state.SetItemsProcessed(state.iterations() * pixels_count(image));
+    state.SetLabel("pixels");
+}
+BENCHMARK(BM_CompressBC3)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+/** Builds the gamma-correct mipmaps that are compressed above. */
+static void BM_BuildMipChain(benchmark::State& state) {
+    const MipChain image = test_image(false);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(build_mip_chain(image_size, image_size, image.pixels.data()));
+    }
+    state.SetItemsProcessed(state.iterations() * image_size * image_size);
+}
+BENCHMARK(BM_BuildMipChain)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
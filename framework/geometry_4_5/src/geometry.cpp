@@ -18,8 +18,15 @@
 Geometry::Geometry(GLenum mode, int elements_per_vertex, int vertices_count, const float* vertices, int indices_count,
                    const uint32_t* indices, GLint position_loc, GLint normal_loc, GLint tex_coord_loc, GLint tangent_loc,
                    GLint bitangent_loc)
+    : Geometry(mode, elements_per_vertex, vertices_count, vertices, indices_count, indices, GL_UNSIGNED_INT,
+               position_loc, normal_loc, tex_coord_loc, tangent_loc, bitangent_loc) {}
+
+Geometry::Geometry(GLenum mode, int elements_per_vertex, int vertices_count, const float* vertices, int indices_count,
+                   const void* indices, GLenum index_type, GLint position_loc, GLint normal_loc, GLint tex_coord_loc,
+                   GLint tangent_loc, GLint bitangent_loc, GLint color_loc)
     : Geometry_Base(mode, elements_per_vertex, vertices_count, indices_count, position_loc, normal_loc, tex_coord_loc,
-                    tangent_loc, bitangent_loc) {
+                    tangent_loc, bitangent_loc, color_loc) {
+    this->index_type = index_type;
 
     // Creates a single buffer for vertex data.
     glCreateBuffers(1, &vertex_buffer);
@@ -30,7 +37,27 @@ Geometry::Geometry(GLenum mode, int elements_per_vertex, int vertices_count, con
     if (indices && indices_count > 0) {
         // Creates a buffer for indices.
         glCreateBuffers(1, &index_buffer);
-        glNamedBufferStorage(index_buffer, indices_count * sizeof(uint32_t), indices, GL_DYNAMIC_STORAGE_BIT);
+        glNamedBufferStorage(index_buffer, indices_count * index_size(), indices, GL_DYNAMIC_STORAGE_BIT);
+        glVertexArrayElementBuffer(vao, index_buffer);
+    }
+}
+
+Geometry::Geometry(const MeshData& mesh, GLenum mode)
+    : Geometry(mode, MeshData::ELEMENTS_PER_VERTEX, mesh.vertices_count(), mesh.vertices.data(), 0, nullptr,
+               mesh.index_type(), DEFAULT_POSITION_LOC, DEFAULT_NORMAL_LOC, DEFAULT_TEX_COORD_LOC, -1, -1, -1) {
+    // Creates a buffer for indices, converting them to the smaller type if possible. A mesh without indices is drawn
+    // by glDrawArrays (an empty buffer storage would be an error).
+    if (mesh.indices_count() > 0) {
+        draw_elements_count = mesh.indices_count();
+        glCreateBuffers(1, &index_buffer);
+        if (index_type == GL_UNSIGNED_SHORT) {
+            const std::vector<uint16_t> short_indices(mesh.indices.begin(), mesh.indices.end());
+            glNamedBufferStorage(index_buffer, short_indices.size() * sizeof(uint16_t), short_indices.data(),
+                                 GL_DYNAMIC_STORAGE_BIT);
+        } else {
+            glNamedBufferStorage(index_buffer, mesh.indices.size() * sizeof(uint32_t), mesh.indices.data(),
+                                 GL_DYNAMIC_STORAGE_BIT);
+        }
         glVertexArrayElementBuffer(vao, index_buffer);
     }
 }
@@ -82,8 +109,8 @@ Geometry::Geometry(const Geometry& other)
     // Creates a buffer for indices.
     if (draw_elements_count > 0) {
         glCreateBuffers(1, &index_buffer);
-        glNamedBufferStorage(index_buffer, draw_elements_count * sizeof(unsigned int), nullptr, GL_DYNAMIC_STORAGE_BIT);
-        glCopyNamedBufferSubData(other.index_buffer, index_buffer, 0, 0, draw_elements_count * sizeof(unsigned int));
+        glNamedBufferStorage(index_buffer, draw_elements_count * index_size(), nullptr, GL_DYNAMIC_STORAGE_BIT);
+        glCopyNamedBufferSubData(other.index_buffer, index_buffer, 0, 0, draw_elements_count * index_size());
     }
 
     init_vao();
@@ -0,0 +1,47 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include "profiler.h"
+#include <string>
+
+/**
+ * The ImGui window showing the history of a {@link Profiler}: the frame times, the CPU and GPU bars of the scopes of a
+ * frame laid out by their nesting, the average times of the scopes, and the export of the history into a CSV file.
+ */
+class ProfilerPanel {
+
+    // ----------------------------------------------------------------------------
+    // Variables
+    // ----------------------------------------------------------------------------
+private:
+    /** The age of the frame whose scopes are shown, 0 follows the most recent frame. */
+    int selected_age = 0;
+
+    /** The file the history is exported to. */
+    std::string csv_path = "profile.csv";
+
+    /** The result of the last export. */
+    std::string export_status;
+
+    // ----------------------------------------------------------------------------
+    // Methods
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Renders the window, it must be called between ImGui::NewFrame and ImGui::Render.
+     *
+     * @param 	profiler	The profiler to show.
+     * @param 	fps_cpu 	The FPS measured on CPU, shown in the header.
+     */
+    void render(const Profiler& profiler, float fps_cpu);
+
+private:
+    /** Draws the bars of the scopes of the frame, either the CPU or the GPU times. */
+    void render_bars(const Profiler::Frame& frame, bool gpu) const;
+};
@@ -0,0 +1,139 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "profiler_panel.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <functional>
+#include <imgui.h>
+#include <string_view>
+
+// ----------------------------------------------------------------------------
+// Methods
+// ----------------------------------------------------------------------------
+void ProfilerPanel::render(const Profiler& profiler, float fps_cpu) {
+    ImGui::Begin("Profiler");
+
+    const size_t frame_count = profiler.get_frame_count();
+    if (frame_count == 0) {
+        ImGui::Text("Waiting for the first frames");
+        ImGui::End();
+        return;
+    }
+
+    const Profiler::Sample& latest = profiler.get_frame(0).samples.front();
+    ImGui::Text("%.1f FPS, frame %.2f ms CPU, %.2f ms GPU", fps_cpu, latest.cpu_time, latest.gpu_time);
+
+    // The frame times from the oldest to the most recent frame
+    std::vector<float> cpu_times(frame_count);
+    std::vector<float> gpu_times(frame_count);
+    for (size_t age = 0; age < frame_count; age++) {
+        const Profiler::Sample& frame = profiler.get_frame(age).samples.front();
+        cpu_times[frame_count - 1 - age] = float(frame.cpu_time);
+        gpu_times[frame_count - 1 - age] = float(frame.gpu_time);
+    }
+    const ImVec2 plot_size(0.0f, 3.0f * ImGui::GetFontSize());
+    ImGui::PlotLines("CPU ms", cpu_times.data(), int(frame_count), 0, nullptr, 0.0f, FLT_MAX, plot_size);
+    ImGui::PlotLines("GPU ms", gpu_times.data(), int(frame_count), 0, nullptr, 0.0f, FLT_MAX, plot_size);
+
+    ImGui::SliderInt("Frame age", &selected_age, 0, int(frame_count) - 1);
+    const Profiler::Frame& frame = profiler.get_frame(std::min(size_t(selected_age), frame_count - 1));
+
+    ImGui::Text("CPU");
+    render_bars(frame, false);
+    ImGui::Text("GPU");
+    render_bars(frame, true);
+
+    // The averages over the history, in the order of the scopes of the shown frame
+    struct Average {
+        std::string_view name;
+        int depth;
+        double cpu_time = 0.0;
+        double gpu_time = 0.0;
+    };
+    std::vector<Average> averages;
+    for (const Profiler::Sample& sample : frame.samples)
+        if (std::none_of(averages.begin(), averages.end(), [&](const Average& a) { return a.name == sample.name; }))
+            averages.push_back({sample.name, sample.depth});
+
+    for (size_t age = 0; age < frame_count; age++) {
+        for (const Profiler::Sample& sample : profiler.get_frame(age).samples) {
+            auto average = std::find_if(averages.begin(), averages.end(),
+                                        [&](const Average& a) { return a.name == sample.name; });
+            if (average != averages.end()) {
+                average->cpu_time += sample.cpu_time / double(frame_count);
+                average->gpu_time += sample.gpu_time / double(frame_count);
+            }
+        }
+    }
+
+    if (ImGui::BeginTable("Averages", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV)) {
+        ImGui::TableSetupColumn("Scope");
+        ImGui::TableSetupColumn("CPU ms");
+        ImGui::TableSetupColumn("GPU ms");
+        ImGui::TableHeadersRow();
+        for (const Average& average : averages) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Indent(float(average.depth) * ImGui::GetFontSize());
+            ImGui::TextUnformatted(average.name.data(), average.name.data() + average.name.size());
+            ImGui::Unindent(float(average.depth) * ImGui::GetFontSize());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", average.cpu_time);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", average.gpu_time);
+        }
+        ImGui::EndTable();
+    }
+
+    if (ImGui::Button("Export CSV"))
+        export_status = profiler.export_csv(csv_path) ? "Written to " + csv_path : "Could not write " + csv_path;
+    if (!export_status.empty()) {
+        ImGui::SameLine();
+        ImGui::TextUnformatted(export_status.c_str());
+    }
+
+    ImGui::End();
+}
+
+void ProfilerPanel::render_bars(const Profiler::Frame& frame, bool gpu) const {
+    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    const float width = std::max(ImGui::GetContentRegionAvail().x, 1.0f);
+    const float row_height = ImGui::GetFrameHeight();
+
+    const Profiler::Sample& whole = frame.samples.front();
+    const double frame_time = gpu ? whole.gpu_time : whole.cpu_time;
+    const float scale = width / float(std::max(frame_time, 1e-6));
+
+    int max_depth = 0;
+    for (const Profiler::Sample& sample : frame.samples) {
+        max_depth = std::max(max_depth, sample.depth);
+
+        const float start = float(gpu ? sample.gpu_start : sample.cpu_start);
+        const float time = float(gpu ? sample.gpu_time : sample.cpu_time);
+        const ImVec2 min(origin.x + start * scale, origin.y + float(sample.depth) * row_height);
+        const ImVec2 max(min.x + std::max(time * scale, 1.0f), min.y + row_height - 1.0f);
+
+        // The color is derived from the name, so a scope keeps its color between the frames and the two views
+        const float hue = float(std::hash<std::string_view>{}(sample.name) % 360) / 360.0f;
+        draw_list->AddRectFilled(min, max, ImColor::HSV(hue, 0.45f, 0.95f));
+        draw_list->AddRect(min, max, IM_COL32(0, 0, 0, 96));
+
+        char label[64];
+        snprintf(label, sizeof(label), "%s %.2f ms", sample.name, time);
+        draw_list->PushClipRect(min, max, true);
+        draw_list->AddText(ImVec2(min.x + 2.0f, min.y + ImGui::GetStyle().FramePadding.y), IM_COL32_BLACK, label);
+        draw_list->PopClipRect();
+
+        if (ImGui::IsMouseHoveringRect(min, max))
+            ImGui::SetTooltip("%s", label);
+    }
+
+    ImGui::Dummy(ImVec2(width, float(max_depth + 1) * row_height));
+}
@@ -0,0 +1,93 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include "utilities.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * The binaries of linked programs cached on disk (see glGetProgramBinary), so that the programs whose sources did not
+ * change are not compiled again by the next run.
+ * <p>
+ * A binary is valid only for the driver that produced it, hence it is stored with a key hashing the final sources of
+ * all stages (i.e., with the defines added) together with the vendor, the renderer and the version of the driver.
+ * The cache files are stored in the cache directory of the build (see {@link set_directory}), named by the first
+ * shader, the paths and the defines of the program, and the key. Storing a new binary of a program removes its
+ * binaries with other keys. A missing file, or a binary rejected by the driver, is a miss and the program has to be
+ * compiled.
+ */
+class ProgramCache {
+
+    // ----------------------------------------------------------------------------
+    // Static Variables
+    // ----------------------------------------------------------------------------
+public:
+    /** The extension of the cache files. */
+    static constexpr const char* EXTENSION = ".glprog";
+
+    /** The version of the cache files, the files of other versions are ignored. */
+    static constexpr uint32_t VERSION = 1;
+
+private:
+    /** The directory with the cache files, the programs are not cached if empty. */
+    static std::filesystem::path directory;
+
+    // ----------------------------------------------------------------------------
+    // Methods
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Computes the key of a program for the current driver.
+     *
+     * @param 	sources	The types and the final sources of the stages.
+     * @return	The FNV-1a hash of the sources and the driver strings.
+     */
+    static uint64_t compute_key(const std::vector<std::pair<GLenum, std::string>>& sources);
+
+    /**
+     * Sets the directory with the cache files, which is created when the first binary is stored.
+     *
+     * @param 	directory	The path to the directory, or an empty path to disable the cache.
+     */
+    static void set_directory(const std::filesystem::path& directory);
+
+    /**
+     * Returns the path of the cache file of a program.
+     *
+     * @param 	stage_paths	The paths to the shaders of the program.
+     * @param 	defines	   	The defines of the program.
+     * @param 	key		   	The key of the program, see {@link compute_key}.
+     * @return	The path to the cache file, or an empty path if the programs are not cached.
+     */
+    static std::filesystem::path cache_path(const std::vector<std::filesystem::path>& stage_paths,
+                                            const std::vector<std::string>& defines, uint64_t key);
+
+    /**
+     * Creates a program from its cached binary.
+     *
+     * @param 	path	The path to the cache file.
+     * @param 	key 	The key of the program, see {@link compute_key}.
+     * @return	The linked program, or 0 if there is no valid binary of the key.
+     */
+    static GLuint load(const std::filesystem::path& path, uint64_t key);
+
+    /**
+     * Stores the binary of a linked program, which should have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT, and
+     * removes the cache files of the same program with other keys.
+     *
+     * @param 	path   	The path to the cache file.
+     * @param 	key	   	The key of the program, see {@link compute_key}.
+     * @param 	program	The linked program.
+     * @return	The flag determining if the binary was stored.
+     */
+    static bool store(const std::filesystem::path& path, uint64_t key, GLuint program);
+};
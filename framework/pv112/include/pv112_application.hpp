@@ -20,6 +20,9 @@ protected:
     /** The absolute path to applications shaders. Loaded from {@link configuration} if a configuration file is available. */
     std::filesystem::path lecture_shaders_path;
 
+    /** The absolute path to the cache files of the build (e.g., program binaries), empty without configuration. */
+    std::filesystem::path cache_folder_path;
+
 public:
     // ----------------------------------------------------------------------------
     // Constructors & Destructors
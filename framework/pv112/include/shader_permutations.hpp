@@ -0,0 +1,87 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include "shader_program.hpp"
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * The variants of a program specialized by #defines, e.g., {"TEXTURED", "LIGHTS=2"}, so that the shaders branch on
+ * the defines at compile time instead of on uniforms at run time.
+ * <p>
+ * A variant is submitted for compilation the first time it is requested and cached under its permutation key, which
+ * is the sorted list of its defines joined by " | " (e.g., "LIGHTS=2 | TEXTURED"). The order of the requested defines
+ * does not matter. The variants requested together, and the ones submitted by {@link reload}, are compiled by the
+ * driver in parallel, and {@link poll} replaces them as they link.
+ */
+class ShaderPermutations {
+
+    // ----------------------------------------------------------------------------
+    // Variables
+    // ----------------------------------------------------------------------------
+private:
+    std::filesystem::path vertex_path;
+    std::filesystem::path fragment_path;
+
+    /** The compiled variants by their permutation keys. */
+    std::map<std::string, std::unique_ptr<ShaderProgram>, std::less<>> variants;
+
+    // ----------------------------------------------------------------------------
+    // Constructors & Destructors
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Creates a new {@link ShaderPermutations}, no variant is compiled until it is requested.
+     *
+     * @param 	vertex_path  	The path to the vertex shader.
+     * @param 	fragment_path	The path to the fragment shader.
+     */
+    ShaderPermutations(std::filesystem::path vertex_path, std::filesystem::path fragment_path);
+
+    // ----------------------------------------------------------------------------
+    // Methods
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Returns the variant with the specified defines, submitting its compilation if it was not requested before. A new
+     * variant has no program until it links, see {@link ShaderProgram::poll} and {@link ShaderProgram::wait}.
+     *
+     * @param 	defines	The defines, either "NAME" or "NAME=VALUE".
+     * @return	The variant, it stays valid until the {@link ShaderPermutations} is destroyed.
+     */
+    ShaderProgram& get(std::vector<std::string> defines);
+
+    /** Submits the recompilation of all variants compiled so far, see {@link ShaderProgram::reload}. */
+    void reload();
+
+    /**
+     * Replaces the variants that finished linking, see {@link ShaderProgram::poll}.
+     *
+     * @return	The flag determining if any variant was replaced.
+     */
+    bool poll();
+
+    /** Returns the files the variants are compiled from, see {@link ShaderProgram::get_dependencies}. */
+    std::vector<std::filesystem::path> get_dependencies() const;
+
+    /**
+     * Returns the counter increased whenever {@link get_dependencies} changes, i.e., when a variant is created or the
+     * dependencies of a variant change.
+     */
+    uint64_t get_dependencies_generation() const;
+
+    /** Returns the number of compiled variants. */
+    size_t get_variant_count() const { return variants.size(); }
+
+    /** Returns the permutation key of the defines, see {@link ShaderPermutations}. */
+    static std::string get_key(std::vector<std::string> defines);
+};
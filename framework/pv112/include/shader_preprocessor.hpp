@@ -0,0 +1,79 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Resolves the #include "path" directives of shaders before they are passed to the driver, the paths are relative to
+ * the including file (e.g., #include "include/camera.glsl").
+ * <p>
+ * Every file is included at most once per shader, as if it had an include guard, so the shared files may include each
+ * other freely. The directives are resolved regardless of the surrounding #if blocks. Each file is assigned its own
+ * source string number, the main file 0 and the included files 1, 2, ... in the order of their inclusion, and #line
+ * directives keep the line numbers of the files, so the messages of the driver can be mapped back to them (see
+ * {@link format_shader_log}).
+ * <p>
+ * The expanded sources are cached and reused until any of their files is modified, so the files shared by many
+ * programs are read once per reload.
+ */
+class ShaderPreprocessor {
+
+    // ----------------------------------------------------------------------------
+    // Nested Types
+    // ----------------------------------------------------------------------------
+public:
+    /** An expanded shader. */
+    struct Result {
+        /** The source with the included files. */
+        std::string source;
+        /** The files of the source by their source string numbers, the first one is the main file. */
+        std::vector<std::filesystem::path> files;
+    };
+
+private:
+    /** A cached file or expanded shader with the modification times of the files it was read from. */
+    template <typename T> struct CacheEntry {
+        T value;
+        std::vector<std::pair<std::filesystem::path, std::filesystem::file_time_type>> write_times;
+    };
+
+    // ----------------------------------------------------------------------------
+    // Methods
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Expands the #include directives of a shader.
+     *
+     * @param 	path	The path to the shader.
+     * @return	The expanded shader, the unresolved directives are replaced by #error.
+     */
+    static const Result& preprocess(const std::filesystem::path& path);
+
+private:
+    /** Appends the lines of a file to the result, expanding its #include directives recursively. */
+    static void expand(const std::filesystem::path& path, int source_number, Result& result);
+
+    /** Returns the content of a file, it is read again only if it was modified. */
+    static const std::string& read(const std::filesystem::path& path);
+
+    /** Checks whether the files of a cache entry were not modified. */
+    template <typename T> static bool is_valid(const CacheEntry<T>& entry);
+
+    /** Returns the normalized absolute path of a file, the key of the caches. */
+    static std::filesystem::path normalize(const std::filesystem::path& path);
+
+    /** Returns the cache of the expanded shaders. */
+    static std::map<std::filesystem::path, CacheEntry<Result>>& get_results();
+
+    /** Returns the cache of the files. */
+    static std::map<std::filesystem::path, CacheEntry<std::string>>& get_files();
+};
@@ -0,0 +1,310 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include "glm_headers.hpp"
+#include "utilities.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * The OpenGL program created from shader files, its active uniforms, uniform blocks and storage blocks are reflected
+ * once after every link.
+ * <p>
+ * The setters write the uniforms by glProgramUniform*, so the program does not have to be bound. The last value of
+ * every reflected uniform is cached and the values that did not change are not written again, hence the uniforms must
+ * not be written by glUniform* directly. The uniforms can be set by the locations declared in the shaders, or by their
+ * names, which are looked up in the reflected map instead of asking the driver.
+ * <p>
+ * {@link reload} recompiles the program from the same files (e.g., from {@link GUIApplication::compile_shaders} when R
+ * is pressed), the reflection is rebuilt and the cached values are dropped. The linked binaries are kept by the
+ * {@link ProgramCache}, so a program is compiled only when its sources or the driver changed, and a reload of sources
+ * that did not change keeps the current program.
+ * <p>
+ * The compilation does not block: {@link reload} only submits the shaders and the link, which the driver runs in
+ * background threads if it supports GL_KHR_parallel_shader_compile. The current program stays in use until {@link
+ * poll} (called once per frame) finds the new one linked, a program that fails to link is reported and dropped. Hence
+ * many programs are best reloaded together and waited for by {@link wait} only when they are needed at once, e.g.,
+ * after the application created them.
+ */
+class ShaderProgram {
+
+    // ----------------------------------------------------------------------------
+    // Nested Types
+    // ----------------------------------------------------------------------------
+public:
+    /** An active uniform outside of the blocks. */
+    struct Uniform {
+        /** The name of the uniform, without the "[0]" suffix of arrays. */
+        std::string name;
+        GLint location;
+        GLenum type;
+        GLint array_size;
+        /** The texture or image unit of a sampler or image uniform, -1 for the other types. */
+        GLint unit;
+    };
+
+    /** An active member of a block. */
+    struct BlockMember {
+        /** The name of the member without the block name, e.g., "lights[1].position" or "objects[0].model_matrix". */
+        std::string name;
+        GLint offset;
+        /** The stride of the top-level array of a storage block member, 0 for uniform blocks and other members. */
+        GLint top_level_stride;
+    };
+
+    /** An active uniform or shader storage block. */
+    struct Block {
+        std::string name;
+        GLint binding;
+        /** The minimum size of the bound buffer in bytes. */
+        GLint data_size;
+        std::vector<BlockMember> members;
+    };
+
+    /**
+     * The layout of a C++ structure mirroring a block, or an element of an array in a block, see {@link
+     * add_block_layout}. The offsets of the fields are given by offsetof, e.g., {"position", offsetof(LightUBO,
+     * position)}.
+     */
+    struct BlockLayout {
+        /** The name of the block. */
+        std::string block;
+        /** The name of the array of the structures in the block (e.g., "lights"), empty if the structure is the block. */
+        std::string array;
+        /** The size of the structure, the stride of the array. */
+        size_t size;
+        /** The names of the fields in GLSL with their offsets in the structure. */
+        std::vector<std::pair<std::string, size_t>> fields;
+    };
+
+private:
+    /** A shader file the program is created from. */
+    struct Stage {
+        GLenum type;
+        std::filesystem::path path;
+    };
+
+    /** A program submitted by {@link reload} that replaces the current one once it links. */
+    struct Pending {
+        GLuint program = 0;
+        /** The {@link ProgramCache} key of the sources. */
+        uint64_t key = 0;
+        /** The shaders of the stages, deleted once their compile status is reported. */
+        std::vector<GLuint> shaders;
+        /** The files of the sources of the stages by their source string numbers, see {@link ShaderPreprocessor}. */
+        std::vector<std::vector<std::filesystem::path>> source_files;
+        std::filesystem::path cache_path;
+    };
+
+    /** The last value written to a uniform, its size is 0 until the first write. */
+    struct CachedValue {
+        std::array<std::byte, 64> bytes;
+        size_t size = 0;
+    };
+
+    // ----------------------------------------------------------------------------
+    // Variables
+    // ----------------------------------------------------------------------------
+private:
+    /** The shader files the program is created from. */
+    std::vector<Stage> stages;
+
+    /** The defines added to every stage, see {@link add_defines}. */
+    std::vector<std::string> defines;
+
+    /** The files of all stages including the included ones, as of the last {@link reload}. */
+    std::vector<std::filesystem::path> dependencies;
+
+    /** The number of times {@link dependencies} changed, see {@link get_dependencies_generation}. */
+    uint64_t dependencies_generation = 0;
+
+    /** The name of the OpenGL program. */
+    GLuint program = 0;
+
+    /** The {@link ProgramCache} key of the current program, 0 until a program links. */
+    uint64_t key = 0;
+
+    /** The program being compiled in the background, its name is 0 if there is none. */
+    Pending pending;
+
+    /** The reflected uniforms and their cached values. */
+    std::vector<Uniform> uniforms;
+    std::vector<CachedValue> values;
+
+    /** The indices of the uniforms by their names and locations (-1 for the locations without a uniform). */
+    std::map<std::string, int, std::less<>> uniform_of_name;
+    std::vector<int> uniform_of_location;
+
+    /** The reflected blocks. */
+    std::vector<Block> uniform_blocks;
+    std::vector<Block> storage_blocks;
+
+    // ----------------------------------------------------------------------------
+    // Constructors & Destructors
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Creates a new {@link ShaderProgram} from a vertex and a fragment shader, the program is linked in the background
+     * (see {@link wait}).
+     *
+     * @param 	vertex_path  	The path to the vertex shader.
+     * @param 	fragment_path	The path to the fragment shader.
+     * @param 	defines		 	The defines added to both shaders, either "NAME" or "NAME=VALUE".
+     */
+    ShaderProgram(std::filesystem::path vertex_path, std::filesystem::path fragment_path,
+                  std::vector<std::string> defines = {});
+
+    /**
+     * Creates a new {@link ShaderProgram} from a compute shader, the program is linked in the background (see {@link
+     * wait}).
+     *
+     * @param 	compute_path	The path to the compute shader.
+     * @param 	defines			The defines added to the shader, either "NAME" or "NAME=VALUE".
+     */
+    explicit ShaderProgram(std::filesystem::path compute_path, std::vector<std::string> defines = {});
+
+    ShaderProgram(const ShaderProgram&) = delete;
+    ShaderProgram& operator=(const ShaderProgram&) = delete;
+
+    /** Deletes the program, the OpenGL context must still be current. */
+    ~ShaderProgram();
+
+    // ----------------------------------------------------------------------------
+    // Methods
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Submits the compilation of the program from its shader files, nothing is compiled if the sources did not change
+     * and a program loaded from the {@link ProgramCache} replaces the current one immediately.
+     */
+    void reload();
+
+    /**
+     * Replaces the current program by the submitted one if it finished linking, reflecting it again.
+     *
+     * @return	The flag determining if the program was replaced.
+     */
+    bool poll();
+
+    /** Waits for the submitted program like {@link poll} would, if there is any. */
+    void wait();
+
+    /** Checks whether a program is being compiled in the background. */
+    bool is_pending() const { return pending.program != 0; }
+
+    /** Returns the name of the OpenGL program. */
+    GLuint get_name() const { return program; }
+
+    /**
+     * Returns the files the program is compiled from, including the included ones, a change of any of them requires
+     * a {@link reload}.
+     */
+    const std::vector<std::filesystem::path>& get_dependencies() const { return dependencies; }
+
+    /** Returns the counter increased whenever {@link get_dependencies} changes, e.g., by a new #include. */
+    uint64_t get_dependencies_generation() const { return dependencies_generation; }
+
+    /** Binds the program by glUseProgram. */
+    void use() const;
+
+    /** Returns the reflected uniforms. */
+    const std::vector<Uniform>& get_uniforms() const { return uniforms; }
+
+    /** Returns the reflected uniform blocks. */
+    const std::vector<Block>& get_uniform_blocks() const { return uniform_blocks; }
+
+    /** Returns the reflected shader storage blocks. */
+    const std::vector<Block>& get_storage_blocks() const { return storage_blocks; }
+
+    /** Returns the uniform of the specified name, or null if the program has no such active uniform. */
+    const Uniform* find_uniform(std::string_view name) const;
+
+    /** Returns the location of the uniform of the specified name, or -1 if the program has no such active uniform. */
+    GLint get_uniform_location(std::string_view name) const;
+
+    /**
+     * Writes the value of a uniform unless it is the cached one. The locations without a reflected uniform (e.g., the
+     * elements of arrays after the first one) are written without caching, the negative locations are ignored.
+     *
+     * @param 	location	The location of the uniform.
+     * @param 	value   	The value, one of bool, int, unsigned int, float or their glm vectors, or glm::mat3/mat4.
+     */
+    template <typename T> void set(GLint location, const T& value);
+
+    /** Writes the value of a uniform like {@link set}, the uniform is specified by its name. */
+    template <typename T> void set(std::string_view name, const T& value) { set(get_uniform_location(name), value); }
+
+    /**
+     * Registers the C++ structure mirroring a block, every program declaring the block is checked against it whenever
+     * it links and the members whose offsets differ (or which the structure lacks) are reported. The layouts should be
+     * registered before the programs are created.
+     */
+    static void add_block_layout(BlockLayout layout);
+
+private:
+    /** Reports the status of the submitted program, replaces the current one by it if it linked or drops it. */
+    bool finish();
+
+    /** Deletes the submitted program and its shaders without waiting for them. */
+    void discard_pending();
+
+    /** Replaces the current program by a linked one. */
+    void replace(GLuint linked, uint64_t linked_key);
+
+    /** Reads the active uniforms and blocks of the linked program. */
+    void reflect();
+
+    /** Reports the differences between a reflected block and its registered layout. */
+    void validate_block(const Block& block, const BlockLayout& layout) const;
+
+    /** Returns the registered layouts by the names of the blocks. */
+    static std::map<std::string, BlockLayout, std::less<>>& get_block_layouts();
+
+    // The glProgramUniform* call of each supported type
+    void write(GLint location, bool value) const;
+    void write(GLint location, GLint value) const;
+    void write(GLint location, GLuint value) const;
+    void write(GLint location, float value) const;
+    void write(GLint location, const glm::vec2& value) const;
+    void write(GLint location, const glm::vec3& value) const;
+    void write(GLint location, const glm::vec4& value) const;
+    void write(GLint location, const glm::ivec2& value) const;
+    void write(GLint location, const glm::ivec3& value) const;
+    void write(GLint location, const glm::ivec4& value) const;
+    void write(GLint location, const glm::uvec2& value) const;
+    void write(GLint location, const glm::uvec3& value) const;
+    void write(GLint location, const glm::uvec4& value) const;
+    void write(GLint location, const glm::mat3& value) const;
+    void write(GLint location, const glm::mat4& value) const;
+};
+
+template <typename T> void ShaderProgram::set(GLint location, const T& value) {
+    static_assert(sizeof(T) <= sizeof(CachedValue::bytes), "The value is too large to be cached");
+
+    if (location < 0)
+        return;
+
+    if (location < GLint(uniform_of_location.size()) && uniform_of_location[location] >= 0) {
+        CachedValue& cached = values[uniform_of_location[location]];
+        if (cached.size == sizeof(T) && std::memcmp(cached.bytes.data(), &value, sizeof(T)) == 0)
+            return;
+
+        std::memcpy(cached.bytes.data(), &value, sizeof(T));
+        cached.size = sizeof(T);
+    }
+
+    write(location, value);
+}
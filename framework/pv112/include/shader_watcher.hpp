@@ -0,0 +1,129 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#pragma once
+
+#include "shader_permutations.hpp"
+#include "shader_program.hpp"
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <set>
+#include <vector>
+
+/**
+ * Watches a directory of shaders and reloads only the programs that depend on the changed files, so that editing a
+ * shader recompiles its programs (in the background, see {@link ShaderProgram::reload}) while the rest is untouched.
+ * <p>
+ * The watched programs form a dependency graph from the files they are compiled from (see {@link
+ * ShaderProgram::get_dependencies}) to the programs. It is rebuilt by {@link update} only when the dependency
+ * generation of a program changed (e.g., a reload added an #include, or a new permutation was compiled), so the files
+ * added to a program by its last reload are watched as well. On Linux the changes are reported by inotify for the directory
+ * and its subdirectories, elsewhere (or if inotify is not available) the modification times of the files in the graph
+ * are polled every {@link POLL_INTERVAL}.
+ */
+class ShaderWatcher {
+
+    // ----------------------------------------------------------------------------
+    // Nested Types
+    // ----------------------------------------------------------------------------
+private:
+    /** A program, or a set of permutations, reloaded when any of its dependencies changes. */
+    struct Target {
+        std::function<std::vector<std::filesystem::path>()> get_dependencies;
+        std::function<uint64_t()> get_dependencies_generation;
+        std::function<void()> reload;
+        /** The dependency generation the graph was last built from. */
+        uint64_t generation = 0;
+    };
+
+    // ----------------------------------------------------------------------------
+    // Static Variables
+    // ----------------------------------------------------------------------------
+public:
+    /** The interval of polling the modification times when inotify is not available. */
+    static constexpr std::chrono::milliseconds POLL_INTERVAL{250};
+
+    // ----------------------------------------------------------------------------
+    // Variables
+    // ----------------------------------------------------------------------------
+private:
+    /** The watched directory. */
+    std::filesystem::path directory;
+
+    /** The watched programs. */
+    std::vector<Target> targets;
+
+    /** The indices of the targets by the (normalized) paths of their dependencies. */
+    std::map<std::filesystem::path, std::vector<size_t>> targets_of_file;
+
+    /** The inotify instance, -1 if the modification times are polled instead. */
+    int inotify = -1;
+
+    /** The directories watched by inotify by their watch descriptors. */
+    std::map<int, std::filesystem::path> directory_of_watch;
+
+    /** The last seen modification times of the dependencies, used only when polling. */
+    std::map<std::filesystem::path, std::filesystem::file_time_type> write_times;
+    std::chrono::steady_clock::time_point last_poll;
+
+    // ----------------------------------------------------------------------------
+    // Constructors & Destructors
+    // ----------------------------------------------------------------------------
+public:
+    /**
+     * Creates a new {@link ShaderWatcher} of a directory, no program is watched until it is added.
+     *
+     * @param 	directory	The directory of the shaders, e.g., {@link PV112Application::lecture_shaders_path}.
+     */
+    explicit ShaderWatcher(std::filesystem::path directory);
+
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    /** Stops watching the directory. */
+    ~ShaderWatcher();
+
+    // ----------------------------------------------------------------------------
+    // Methods
+    // ----------------------------------------------------------------------------
+public:
+    /** Watches a program, it must outlive the watcher. */
+    void watch(ShaderProgram& program);
+
+    /** Watches all variants of a set of permutations, including those compiled later, it must outlive the watcher. */
+    void watch(ShaderPermutations& permutations);
+
+    /**
+     * Reloads the programs whose dependencies changed since the last call, the method is supposed to be called once
+     * per frame.
+     *
+     * @return	The number of reloaded programs (a set of permutations counts as one).
+     */
+    size_t update();
+
+    /** Checks whether the changes are reported by inotify rather than polled. */
+    bool is_notified() const { return inotify >= 0; }
+
+private:
+    /** Rebuilds the dependency graph from the current dependencies of the targets. */
+    void build_graph();
+
+    /** Returns the normalized absolute path used as the key of the graph. */
+    static std::filesystem::path normalize(const std::filesystem::path& path);
+
+    /** Adds an inotify watch of a directory and its subdirectories. */
+    void add_watches(const std::filesystem::path& root);
+
+    /** Collects the files reported changed by inotify. */
+    void read_events(std::set<std::filesystem::path>& changed);
+
+    /** Collects the files whose modification times changed. */
+    void poll_write_times(std::set<std::filesystem::path>& changed);
+};
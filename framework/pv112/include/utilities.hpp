@@ -12,9 +12,82 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
+
+// The tokens of GL_KHR_parallel_shader_compile, which are the same as those of GL_ARB_parallel_shader_compile
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
 
 std::string load_file(std::filesystem::path file_path);
 
-GLuint create_shader(std::filesystem::path file_path, GLenum shader_type);
+/**
+ * Inserts a #define for each of the defines after the #version line of the source, followed by a #line directive
+ * keeping the line numbers of the source.
+ *
+ * @param 	source 	The source of a shader.
+ * @param 	defines	The defines, either "NAME" or "NAME=VALUE".
+ * @return	The source with the defines.
+ */
+std::string add_defines(const std::string& source, const std::vector<std::string>& defines);
+
+/**
+ * Compiles a shader from its source and reports the compilation log, the messages are prefixed by the file and the
+ * line they refer to (e.g., "shaders/normal.frag:12: error: ...") whatever the format of the driver is.
+ *
+ * @param 	source	   	 The source of the shader.
+ * @param 	shader_type	 The type of the shader.
+ * @param 	source_files The files of the source by their source string numbers (see {@link ShaderPreprocessor}),
+ * 						 used in the messages.
+ * @return	The shader, which may have failed to compile.
+ */
+GLuint compile_shader(const std::string& source, GLenum shader_type,
+                      const std::vector<std::filesystem::path>& source_files);
+
+/**
+ * Starts the compilation of a shader without waiting for it, see {@link enable_parallel_shader_compile}.
+ *
+ * @param 	source	   	The source of the shader.
+ * @param 	shader_type	The type of the shader.
+ * @return	The shader, its status is checked by {@link check_shader}.
+ */
+GLuint submit_shader(const std::string& source, GLenum shader_type);
+
+/**
+ * Checks the compile status of a shader and reports its compilation log like {@link compile_shader}, waits for the
+ * compilation if it did not finish yet.
+ *
+ * @param 	shader   	 The shader.
+ * @param 	source_files The files of the source by their source string numbers, used in the messages.
+ * @return	The flag determining if the shader is compiled.
+ */
+bool check_shader(GLuint shader, const std::vector<std::filesystem::path>& source_files);
+
+/** Compiles a shader from a file, its #include directives are resolved by {@link ShaderPreprocessor}. */
+GLuint create_shader(std::filesystem::path file_path, GLenum shader_type, const std::vector<std::string>& defines = {});
+
+/**
+ * Checks the link status of a program and reports the link log. The locations in the log are mapped to the files like
+ * in the compilation logs only if the source string numbers are the same for all its shaders (e.g., a compute
+ * program), as the log does not say which shader a message belongs to.
+ *
+ * @param 	program	  	 The program.
+ * @param 	name   	  	 The name of the program used in the messages (e.g., the paths to its shaders).
+ * @param 	source_files The files of the source by their source string numbers, empty to keep the locations as reported.
+ * @return	The flag determining if the program is linked.
+ */
+bool check_program(GLuint program, const std::string& name,
+                   const std::vector<std::filesystem::path>& source_files = {});
+
+/**
+ * Lets the driver compile and link in background threads if it supports GL_KHR_parallel_shader_compile (or the ARB
+ * variant of the extension). The extension is detected and the maximum number of threads is set on the first call.
+ *
+ * @return	The flag determining if GL_COMPLETION_STATUS_KHR of shaders and programs can be queried.
+ */
+bool enable_parallel_shader_compile();
 
 GLuint create_program(std::filesystem::path vertex_path, std::filesystem::path fragment_path);
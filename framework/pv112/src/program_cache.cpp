@@ -0,0 +1,163 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "program_cache.hpp"
+#include "file_utils.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace {
+/** The magic number identifying the cache files. */
+const char cache_magic[4] = {'P', 'G', 'L', 'P'};
+
+/** The header stored at the beginning of every cache file, followed by the binary. */
+struct Header {
+    char magic[4];
+    uint32_t version;
+    /** The key of the program, see {@link ProgramCache::compute_key}. */
+    uint64_t key;
+    /** The format of the binary returned by glGetProgramBinary. */
+    uint32_t format;
+    /** The size of the binary (in bytes). */
+    uint32_t size;
+};
+
+/** Continues the FNV-1a hash with the string and its terminating null character, so that the strings are separated. */
+uint64_t hash_string(uint64_t hash, const std::string& string) {
+    return FileUtils::hash_bytes(hash, string.c_str(), string.size() + 1);
+}
+
+/** Returns the hash as 16 hexadecimal digits preceded by a dot. */
+std::string hash_suffix(uint64_t hash) {
+    char suffix[24];
+    std::snprintf(suffix, sizeof(suffix), ".%016llx", static_cast<unsigned long long>(hash));
+    return suffix;
+}
+
+/** Returns the name of the cache file without the key, i.e., the part shared by all binaries of a program. */
+std::string program_prefix(const std::filesystem::path& path) {
+    const std::string name = path.filename().string();
+    const size_t key_length = hash_suffix(0).size() + std::strlen(ProgramCache::EXTENSION);
+    return name.size() > key_length ? name.substr(0, name.size() - key_length) : name;
+}
+} // namespace
+
+// ----------------------------------------------------------------------------
+// Static Variables
+// ----------------------------------------------------------------------------
+
+std::filesystem::path ProgramCache::directory;
+
+// ----------------------------------------------------------------------------
+// Methods
+// ----------------------------------------------------------------------------
+
+uint64_t ProgramCache::compute_key(const std::vector<std::pair<GLenum, std::string>>& sources) {
+    uint64_t hash = FileUtils::FNV_OFFSET_BASIS;
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        const GLubyte* value = glGetString(name);
+        hash = hash_string(hash, value ? reinterpret_cast<const char*>(value) : "");
+    }
+
+    for (const auto& [type, source] : sources) {
+        hash = FileUtils::hash_bytes(hash, &type, sizeof(type));
+        hash = hash_string(hash, source);
+    }
+    return hash;
+}
+
+void ProgramCache::set_directory(const std::filesystem::path& directory) { ProgramCache::directory = directory; }
+
+std::filesystem::path ProgramCache::cache_path(const std::vector<std::filesystem::path>& stage_paths,
+                                               const std::vector<std::string>& defines, uint64_t key) {
+    if (directory.empty())
+        return {};
+
+    uint64_t hash = FileUtils::FNV_OFFSET_BASIS;
+    for (const std::filesystem::path& stage_path : stage_paths)
+        hash = hash_string(hash, stage_path.generic_string());
+    for (const std::string& define : defines)
+        hash = hash_string(hash, define);
+
+    return directory / (stage_paths.front().filename().string() + hash_suffix(hash) + hash_suffix(key) + EXTENSION);
+}
+
+GLuint ProgramCache::load(const std::filesystem::path& path, uint64_t key) {
+    std::ifstream input{path, std::ios::binary};
+    Header header{};
+    if (!input.read(reinterpret_cast<char*>(&header), sizeof(Header))) {
+        return 0;
+    }
+    if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 || header.version != VERSION
+        || header.key != key || header.size == 0) {
+        return 0;
+    }
+
+    std::vector<char> binary(header.size);
+    if (!input.read(binary.data(), std::streamsize(binary.size()))) {
+        return 0;
+    }
+
+    // The driver may still reject the binary (e.g., after an update that kept its version string)
+    const GLuint program = glCreateProgram();
+    glProgramBinary(program, GLenum(header.format), binary.data(), GLsizei(binary.size()));
+
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+
+bool ProgramCache::store(const std::filesystem::path& path, uint64_t key, GLuint program) {
+    if (path.empty())
+        return false;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return false;
+    }
+
+    std::vector<char> binary(size_t(length), 0);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+    if (length <= 0) {
+        return false;
+    }
+
+    Header header{};
+    std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = VERSION;
+    header.key = key;
+    header.format = format;
+    header.size = uint32_t(length);
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    const bool stored = FileUtils::write_atomically(path, [&](std::ostream& output) {
+        output.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        output.write(binary.data(), std::streamsize(header.size));
+    });
+    if (!stored) {
+        return false;
+    }
+
+    // The binaries of the previous sources of the program would never be loaded again
+    const std::string prefix = program_prefix(path);
+    for (const auto& entry : std::filesystem::directory_iterator(path.parent_path(), error)) {
+        if (entry.path() != path && entry.path().extension() == EXTENSION && program_prefix(entry.path()) == prefix)
+            std::filesystem::remove(entry.path(), error);
+    }
+
+    return true;
+}
@@ -6,6 +6,7 @@
 // ################################################################################
 
 #include "pv112_application.hpp"
+#include "program_cache.hpp"
 
 // ----------------------------------------------------------------------------
 // Constructors & Destructors
@@ -14,6 +15,8 @@
 PV112Application::PV112Application(int initial_width, int initial_height, std::vector<std::string> arguments)
     : GUIApplication(initial_width, initial_height, arguments) {
     lecture_shaders_path = lecture_folder_path / "shaders";
+    cache_folder_path = configuration.get_path("cache_dir");
+    ProgramCache::set_directory(cache_folder_path);
 }
 
 PV112Application::~PV112Application() = default;
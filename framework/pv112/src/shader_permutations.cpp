@@ -0,0 +1,73 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "shader_permutations.hpp"
+
+#include <algorithm>
+
+// ----------------------------------------------------------------------------
+// Constructors & Destructors
+// ----------------------------------------------------------------------------
+
+ShaderPermutations::ShaderPermutations(std::filesystem::path vertex_path, std::filesystem::path fragment_path)
+    : vertex_path(std::move(vertex_path)), fragment_path(std::move(fragment_path)) {}
+
+// ----------------------------------------------------------------------------
+// Methods
+// ----------------------------------------------------------------------------
+
+ShaderProgram& ShaderPermutations::get(std::vector<std::string> defines) {
+    std::sort(defines.begin(), defines.end());
+
+    std::unique_ptr<ShaderProgram>& variant = variants[get_key(defines)];
+    if (!variant)
+        variant = std::make_unique<ShaderProgram>(vertex_path, fragment_path, std::move(defines));
+
+    return *variant;
+}
+
+void ShaderPermutations::reload() {
+    for (auto& [key, variant] : variants)
+        variant->reload();
+}
+
+bool ShaderPermutations::poll() {
+    bool replaced = false;
+    for (auto& [key, variant] : variants)
+        replaced = variant->poll() || replaced;
+    return replaced;
+}
+
+std::vector<std::filesystem::path> ShaderPermutations::get_dependencies() const {
+    std::vector<std::filesystem::path> dependencies = {vertex_path, fragment_path};
+    for (const auto& [key, variant] : variants) {
+        for (const std::filesystem::path& dependency : variant->get_dependencies()) {
+            if (std::find(dependencies.begin(), dependencies.end(), dependency) == dependencies.end())
+                dependencies.push_back(dependency);
+        }
+    }
+
+    return dependencies;
+}
+
+uint64_t ShaderPermutations::get_dependencies_generation() const {
+    // The variants are never removed and their generations never decrease, so the sum changes with any of them
+    uint64_t generation = variants.size();
+    for (const auto& [key, variant] : variants)
+        generation += variant->get_dependencies_generation();
+    return generation;
+}
+
+std::string ShaderPermutations::get_key(std::vector<std::string> defines) {
+    std::sort(defines.begin(), defines.end());
+
+    std::string key;
+    for (const std::string& define : defines)
+        key += (key.empty() ? "" : " | ") + define;
+
+    return key;
+}
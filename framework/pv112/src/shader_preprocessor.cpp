@@ -0,0 +1,123 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "shader_preprocessor.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <system_error>
+
+// ----------------------------------------------------------------------------
+// Methods
+// ----------------------------------------------------------------------------
+
+const ShaderPreprocessor::Result& ShaderPreprocessor::preprocess(const std::filesystem::path& path) {
+    const std::filesystem::path key = normalize(path);
+
+    CacheEntry<Result>& entry = get_results()[key];
+    if (!entry.write_times.empty() && is_valid(entry))
+        return entry.value;
+
+    entry.value = {{}, {key}};
+    expand(key, 0, entry.value);
+
+    // The modification times of the files as they were read
+    entry.write_times.clear();
+    for (const std::filesystem::path& file : entry.value.files)
+        entry.write_times.push_back(get_files()[file].write_times.front());
+
+    return entry.value;
+}
+
+void ShaderPreprocessor::expand(const std::filesystem::path& path, int source_number, Result& result) {
+    std::istringstream lines{read(path)};
+    int line_number = 0;
+    for (std::string line; std::getline(lines, line);) {
+        line_number++;
+
+        const size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line.compare(start, 8, "#include") != 0) {
+            result.source += line + "\n";
+            continue;
+        }
+
+        const size_t open = line.find('"', start + 8);
+        const size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+        if (close == std::string::npos) {
+            result.source += "#error malformed include directive\n";
+            continue;
+        }
+
+        const std::string name = line.substr(open + 1, close - open - 1);
+        const std::filesystem::path included = normalize(path.parent_path() / name);
+
+        // Every file is included once, the line is kept empty so that the line numbers do not change
+        if (std::find(result.files.begin(), result.files.end(), included) != result.files.end()) {
+            result.source += "\n";
+            continue;
+        }
+
+        std::error_code error;
+        if (!std::filesystem::is_regular_file(included, error)) {
+            result.source += "#error could not include " + name + "\n";
+            continue;
+        }
+
+        const int included_number = int(result.files.size());
+        result.files.push_back(included);
+        result.source += "#line 1 " + std::to_string(included_number) + "\n";
+        expand(included, included_number, result);
+        result.source += "#line " + std::to_string(line_number + 1) + " " + std::to_string(source_number) + "\n";
+    }
+}
+
+const std::string& ShaderPreprocessor::read(const std::filesystem::path& path) {
+    CacheEntry<std::string>& entry = get_files()[path];
+    if (!entry.write_times.empty() && is_valid(entry))
+        return entry.value;
+
+    // The time is taken before reading, so a file modified meanwhile is read again next time
+    std::error_code error;
+    const std::filesystem::file_time_type write_time = std::filesystem::last_write_time(path, error);
+    entry.write_times = {{path, error ? std::filesystem::file_time_type::min() : write_time}};
+
+    std::ifstream input{path, std::ios::binary};
+    if (!input.is_open())
+        std::cerr << "File " + path.generic_string() + " not found." << std::endl;
+    entry.value.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+
+    return entry.value;
+}
+
+template <typename T> bool ShaderPreprocessor::is_valid(const CacheEntry<T>& entry) {
+    std::error_code error;
+    for (const auto& [file, write_time] : entry.write_times) {
+        if (std::filesystem::last_write_time(file, error) != write_time || error)
+            return false;
+    }
+    return true;
+}
+
+std::filesystem::path ShaderPreprocessor::normalize(const std::filesystem::path& path) {
+    std::error_code error;
+    const std::filesystem::path absolute = std::filesystem::absolute(path, error);
+    return (error ? path : absolute).lexically_normal();
+}
+
+std::map<std::filesystem::path, ShaderPreprocessor::CacheEntry<ShaderPreprocessor::Result>>&
+ShaderPreprocessor::get_results() {
+    static std::map<std::filesystem::path, CacheEntry<Result>> results;
+    return results;
+}
+
+std::map<std::filesystem::path, ShaderPreprocessor::CacheEntry<std::string>>& ShaderPreprocessor::get_files() {
+    static std::map<std::filesystem::path, CacheEntry<std::string>> files;
+    return files;
+}
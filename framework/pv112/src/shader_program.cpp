@@ -0,0 +1,401 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "shader_program.hpp"
+
+#include "program_cache.hpp"
+#include "shader_preprocessor.hpp"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+/** Checks whether the uniform type is a sampler or an image, i.e., its value is a texture or image unit. */
+bool is_opaque_type(GLenum type) {
+    switch (type) {
+    case GL_SAMPLER_1D:
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_3D:
+    case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_1D_SHADOW:
+    case GL_SAMPLER_2D_SHADOW:
+    case GL_SAMPLER_1D_ARRAY:
+    case GL_SAMPLER_2D_ARRAY:
+    case GL_SAMPLER_1D_ARRAY_SHADOW:
+    case GL_SAMPLER_2D_ARRAY_SHADOW:
+    case GL_SAMPLER_2D_MULTISAMPLE:
+    case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+    case GL_SAMPLER_CUBE_SHADOW:
+    case GL_SAMPLER_CUBE_MAP_ARRAY:
+    case GL_SAMPLER_CUBE_MAP_ARRAY_SHADOW:
+    case GL_SAMPLER_BUFFER:
+    case GL_SAMPLER_2D_RECT:
+    case GL_SAMPLER_2D_RECT_SHADOW:
+    case GL_INT_SAMPLER_1D:
+    case GL_INT_SAMPLER_2D:
+    case GL_INT_SAMPLER_3D:
+    case GL_INT_SAMPLER_CUBE:
+    case GL_INT_SAMPLER_1D_ARRAY:
+    case GL_INT_SAMPLER_2D_ARRAY:
+    case GL_INT_SAMPLER_2D_MULTISAMPLE:
+    case GL_INT_SAMPLER_BUFFER:
+    case GL_UNSIGNED_INT_SAMPLER_1D:
+    case GL_UNSIGNED_INT_SAMPLER_2D:
+    case GL_UNSIGNED_INT_SAMPLER_3D:
+    case GL_UNSIGNED_INT_SAMPLER_CUBE:
+    case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE:
+    case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+    case GL_IMAGE_1D:
+    case GL_IMAGE_2D:
+    case GL_IMAGE_3D:
+    case GL_IMAGE_CUBE:
+    case GL_IMAGE_BUFFER:
+    case GL_IMAGE_1D_ARRAY:
+    case GL_IMAGE_2D_ARRAY:
+    case GL_INT_IMAGE_2D:
+    case GL_INT_IMAGE_3D:
+    case GL_INT_IMAGE_2D_ARRAY:
+    case GL_UNSIGNED_INT_IMAGE_2D:
+    case GL_UNSIGNED_INT_IMAGE_3D:
+    case GL_UNSIGNED_INT_IMAGE_2D_ARRAY:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/** Reads the name of a program resource, without the terminating null character. */
+std::string get_resource_name(GLuint program, GLenum resource_interface, GLuint index, GLint length) {
+    std::string name(size_t(std::max(length, 1)), '\0');
+    GLsizei written = 0;
+    glGetProgramResourceName(program, resource_interface, index, GLsizei(name.size()), &written, name.data());
+    name.resize(size_t(written));
+    return name;
+}
+} // namespace
+
+// ----------------------------------------------------------------------------
+// Constructors & Destructors
+// ----------------------------------------------------------------------------
+
+ShaderProgram::ShaderProgram(std::filesystem::path vertex_path, std::filesystem::path fragment_path,
+                             std::vector<std::string> defines)
+    : stages{{GL_VERTEX_SHADER, std::move(vertex_path)}, {GL_FRAGMENT_SHADER, std::move(fragment_path)}},
+      defines(std::move(defines)) {
+    reload();
+}
+
+ShaderProgram::ShaderProgram(std::filesystem::path compute_path, std::vector<std::string> defines)
+    : stages{{GL_COMPUTE_SHADER, std::move(compute_path)}}, defines(std::move(defines)) {
+    reload();
+}
+
+ShaderProgram::~ShaderProgram() {
+    discard_pending();
+    glDeleteProgram(program);
+}
+
+// ----------------------------------------------------------------------------
+// Methods
+// ----------------------------------------------------------------------------
+
+void ShaderProgram::reload() {
+    std::vector<std::pair<GLenum, std::string>> sources;
+    std::vector<std::vector<std::filesystem::path>> source_files;
+    std::vector<std::filesystem::path> paths;
+    std::vector<std::filesystem::path> files;
+    for (const Stage& stage : stages) {
+        const ShaderPreprocessor::Result& preprocessed = ShaderPreprocessor::preprocess(stage.path);
+        sources.emplace_back(stage.type, add_defines(preprocessed.source, defines));
+        source_files.push_back(preprocessed.files);
+        paths.push_back(stage.path);
+
+        for (const std::filesystem::path& file : preprocessed.files) {
+            if (std::find(files.begin(), files.end(), file) == files.end())
+                files.push_back(file);
+        }
+    }
+    if (files != dependencies) {
+        dependencies = std::move(files);
+        dependencies_generation++;
+    }
+
+    // The same sources are already being compiled, or nothing changed since the last successful link
+    const uint64_t new_key = ProgramCache::compute_key(sources);
+    if (pending.program != 0 && pending.key == new_key)
+        return;
+    discard_pending();
+    if (program != 0 && key == new_key)
+        return;
+
+    const std::filesystem::path cache_path = ProgramCache::cache_path(paths, defines, new_key);
+    if (const GLuint cached = ProgramCache::load(cache_path, new_key)) {
+        replace(cached, new_key);
+        return;
+    }
+
+    // Neither the compile nor the link status is queried here, so the driver may run both in its own threads
+    enable_parallel_shader_compile();
+    pending.program = glCreateProgram();
+    pending.key = new_key;
+    pending.source_files = std::move(source_files);
+    pending.cache_path = cache_path;
+    glProgramParameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    for (const auto& [type, source] : sources) {
+        pending.shaders.push_back(submit_shader(source, type));
+        glAttachShader(pending.program, pending.shaders.back());
+    }
+    glLinkProgram(pending.program);
+}
+
+bool ShaderProgram::poll() {
+    if (pending.program == 0)
+        return false;
+
+    // Without the extension the status cannot be queried without waiting, the link is finished right away
+    if (enable_parallel_shader_compile()) {
+        GLint completed = GL_FALSE;
+        glGetProgramiv(pending.program, GL_COMPLETION_STATUS_KHR, &completed);
+        if (completed != GL_TRUE)
+            return false;
+    }
+
+    return finish();
+}
+
+void ShaderProgram::wait() {
+    if (pending.program != 0)
+        finish();
+}
+
+bool ShaderProgram::finish() {
+    std::string name;
+    for (size_t i = 0; i < stages.size(); i++) {
+        check_shader(pending.shaders[i], pending.source_files[i]);
+        glDetachShader(pending.program, pending.shaders[i]);
+        glDeleteShader(pending.shaders[i]);
+        name += (name.empty() ? "" : " + ") + stages[i].path.generic_string();
+    }
+    pending.shaders.clear();
+
+    // The link log does not say which shader a location belongs to, so it is mapped only for a single shader
+    const std::vector<std::filesystem::path> unknown_files;
+    const bool linked =
+        check_program(pending.program, name, stages.size() == 1 ? pending.source_files.front() : unknown_files);
+    if (linked) {
+        ProgramCache::store(pending.cache_path, pending.key, pending.program);
+        replace(pending.program, pending.key);
+        pending.program = 0;
+    }
+
+    discard_pending();
+    return linked;
+}
+
+void ShaderProgram::discard_pending() {
+    for (GLuint shader : pending.shaders) {
+        glDetachShader(pending.program, shader);
+        glDeleteShader(shader);
+    }
+    glDeleteProgram(pending.program);
+    pending = {};
+}
+
+void ShaderProgram::replace(GLuint linked, uint64_t linked_key) {
+    glDeleteProgram(program);
+    program = linked;
+    key = linked_key;
+    reflect();
+}
+
+void ShaderProgram::use() const { glUseProgram(program); }
+
+void ShaderProgram::add_block_layout(BlockLayout layout) {
+    std::string block = layout.block;
+    get_block_layouts()[std::move(block)] = std::move(layout);
+}
+
+const ShaderProgram::Uniform* ShaderProgram::find_uniform(std::string_view name) const {
+    const auto found = uniform_of_name.find(name);
+    return found != uniform_of_name.end() ? &uniforms[found->second] : nullptr;
+}
+
+GLint ShaderProgram::get_uniform_location(std::string_view name) const {
+    const Uniform* uniform = find_uniform(name);
+    return uniform ? uniform->location : -1;
+}
+
+void ShaderProgram::reflect() {
+    uniforms.clear();
+    values.clear();
+    uniform_of_name.clear();
+    uniform_of_location.clear();
+    uniform_blocks.clear();
+    storage_blocks.clear();
+
+    GLint link_status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+    if (link_status != GL_TRUE)
+        return;
+
+    GLint uniform_count = 0;
+    glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniform_count);
+
+    const GLenum uniform_properties[] = {GL_NAME_LENGTH, GL_TYPE, GL_LOCATION, GL_ARRAY_SIZE, GL_BLOCK_INDEX};
+    for (GLint i = 0; i < uniform_count; i++) {
+        GLint properties[5];
+        glGetProgramResourceiv(program, GL_UNIFORM, GLuint(i), 5, uniform_properties, 5, nullptr, properties);
+
+        // The members of the blocks and the atomic counters have no locations
+        if (properties[4] != -1 || properties[2] < 0)
+            continue;
+
+        Uniform uniform{get_resource_name(program, GL_UNIFORM, GLuint(i), properties[0]), properties[2],
+                        GLenum(properties[1]), properties[3], -1};
+        if (uniform.name.size() > 3 && uniform.name.compare(uniform.name.size() - 3, 3, "[0]") == 0)
+            uniform.name.resize(uniform.name.size() - 3);
+        if (is_opaque_type(uniform.type))
+            glGetUniformiv(program, uniform.location, &uniform.unit);
+
+        const int index = int(uniforms.size());
+        if (uniform_of_location.size() <= size_t(uniform.location))
+            uniform_of_location.resize(size_t(uniform.location) + 1, -1);
+        uniform_of_location[uniform.location] = index;
+        uniform_of_name.emplace(uniform.name, index);
+        uniforms.push_back(std::move(uniform));
+    }
+    values.resize(uniforms.size());
+
+    const GLenum block_properties[] = {GL_NAME_LENGTH, GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE,
+                                       GL_NUM_ACTIVE_VARIABLES};
+    for (auto [resource_interface, blocks] : {std::pair{GL_UNIFORM_BLOCK, &uniform_blocks},
+                                     std::pair{GL_SHADER_STORAGE_BLOCK, &storage_blocks}}) {
+        // The members of the uniform blocks are uniforms, those of the storage blocks are buffer variables
+        const GLenum member_interface = resource_interface == GL_UNIFORM_BLOCK ? GL_UNIFORM : GL_BUFFER_VARIABLE;
+        const GLenum member_properties[] = {GL_NAME_LENGTH, GL_OFFSET, GL_TOP_LEVEL_ARRAY_STRIDE};
+        const GLsizei member_property_count = member_interface == GL_BUFFER_VARIABLE ? 3 : 2;
+
+        GLint block_count = 0;
+        glGetProgramInterfaceiv(program, resource_interface, GL_ACTIVE_RESOURCES, &block_count);
+
+        for (GLint i = 0; i < block_count; i++) {
+            GLint properties[4];
+            glGetProgramResourceiv(program, resource_interface, GLuint(i), 4, block_properties, 4, nullptr, properties);
+            Block block{get_resource_name(program, resource_interface, GLuint(i), properties[0]), properties[1],
+                        properties[2], {}};
+
+            std::vector<GLint> variables(static_cast<size_t>(properties[3]));
+            const GLenum active_variables = GL_ACTIVE_VARIABLES;
+            glGetProgramResourceiv(program, resource_interface, GLuint(i), 1, &active_variables, properties[3],
+                                   nullptr, variables.data());
+            for (GLint variable : variables) {
+                GLint member[3] = {0, 0, 0};
+                glGetProgramResourceiv(program, member_interface, GLuint(variable), member_property_count,
+                                       member_properties, 3, nullptr, member);
+
+                // The members of the blocks with an instance name are prefixed by the block name
+                std::string name = get_resource_name(program, member_interface, GLuint(variable), member[0]);
+                if (name.compare(0, block.name.size() + 1, block.name + ".") == 0)
+                    name.erase(0, block.name.size() + 1);
+                block.members.push_back({std::move(name), member[1], member[2]});
+            }
+
+            const auto layout = get_block_layouts().find(block.name);
+            if (layout != get_block_layouts().end())
+                validate_block(block, layout->second);
+            blocks->push_back(std::move(block));
+        }
+    }
+}
+
+void ShaderProgram::validate_block(const Block& block, const BlockLayout& layout) const {
+    std::string program_name;
+    for (const Stage& stage : stages)
+        program_name += (program_name.empty() ? "" : " + ") + stage.path.filename().generic_string();
+
+    for (const BlockMember& member : block.members) {
+        // The members of an array are named "array[index].field", the element at the index starts at index * size
+        std::string field = member.name;
+        size_t element_offset = 0;
+        if (!layout.array.empty()) {
+            const size_t close = member.name.find("].");
+            if (member.name.compare(0, layout.array.size() + 1, layout.array + "[") != 0 || close == std::string::npos)
+                continue;
+
+            element_offset = std::stoul(member.name.substr(layout.array.size() + 1)) * layout.size;
+            field = member.name.substr(close + 2);
+
+            if (member.top_level_stride != 0 && size_t(member.top_level_stride) != layout.size) {
+                std::cerr << program_name << ": the stride of " << block.name << "." << layout.array << " is "
+                          << member.top_level_stride << " in GLSL but " << layout.size << " in C++" << std::endl;
+            }
+        }
+
+        const auto found = std::find_if(layout.fields.begin(), layout.fields.end(),
+                                        [&field](const auto& layout_field) { return layout_field.first == field; });
+        if (found == layout.fields.end()) {
+            std::cerr << program_name << ": " << block.name << "." << member.name << " has no C++ counterpart"
+                      << std::endl;
+        } else if (size_t(member.offset) != element_offset + found->second) {
+            std::cerr << program_name << ": " << block.name << "." << member.name << " is at offset " << member.offset
+                      << " in GLSL but " << element_offset + found->second << " in C++" << std::endl;
+        }
+    }
+
+    if (layout.array.empty() && size_t(block.data_size) != layout.size) {
+        std::cerr << program_name << ": " << block.name << " has " << block.data_size << " bytes in GLSL but "
+                  << layout.size << " in C++" << std::endl;
+    }
+}
+
+std::map<std::string, ShaderProgram::BlockLayout, std::less<>>& ShaderProgram::get_block_layouts() {
+    static std::map<std::string, BlockLayout, std::less<>> layouts;
+    return layouts;
+}
+
+void ShaderProgram::write(GLint location, bool value) const { glProgramUniform1i(program, location, value); }
+void ShaderProgram::write(GLint location, GLint value) const { glProgramUniform1i(program, location, value); }
+void ShaderProgram::write(GLint location, GLuint value) const { glProgramUniform1ui(program, location, value); }
+void ShaderProgram::write(GLint location, float value) const { glProgramUniform1f(program, location, value); }
+
+void ShaderProgram::write(GLint location, const glm::vec2& value) const {
+    glProgramUniform2fv(program, location, 1, glm::value_ptr(value));
+}
+void ShaderProgram::write(GLint location, const glm::vec3& value) const {
+    glProgramUniform3fv(program, location, 1, glm::value_ptr(value));
+}
+void ShaderProgram::write(GLint location, const glm::vec4& value) const {
+    glProgramUniform4fv(program, location, 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::write(GLint location, const glm::ivec2& value) const {
+    glProgramUniform2iv(program, location, 1, glm::value_ptr(value));
+}
+void ShaderProgram::write(GLint location, const glm::ivec3& value) const {
+    glProgramUniform3iv(program, location, 1, glm::value_ptr(value));
+}
+void ShaderProgram::write(GLint location, const glm::ivec4& value) const {
+    glProgramUniform4iv(program, location, 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::write(GLint location, const glm::uvec2& value) const {
+    glProgramUniform2uiv(program, location, 1, glm::value_ptr(value));
+}
+void ShaderProgram::write(GLint location, const glm::uvec3& value) const {
+    glProgramUniform3uiv(program, location, 1, glm::value_ptr(value));
+}
+void ShaderProgram::write(GLint location, const glm::uvec4& value) const {
+    glProgramUniform4uiv(program, location, 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::write(GLint location, const glm::mat3& value) const {
+    glProgramUniformMatrix3fv(program, location, 1, GL_FALSE, glm::value_ptr(value));
+}
+void ShaderProgram::write(GLint location, const glm::mat4& value) const {
+    glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, glm::value_ptr(value));
+}
@@ -0,0 +1,187 @@
+// ################################################################################
+// Common Framework for Computer Graphics Courses at FI MUNI.
+//
+// Copyright (c) 2021-2022 Visitlab (https://visitlab.fi.muni.cz)
+// All rights reserved.
+// ################################################################################
+
+#include "shader_watcher.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <system_error>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// ----------------------------------------------------------------------------
+// Constructors & Destructors
+// ----------------------------------------------------------------------------
+
+ShaderWatcher::ShaderWatcher(std::filesystem::path directory) : directory(normalize(directory)) {
+#ifdef __linux__
+    inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify >= 0)
+        add_watches(this->directory);
+    if (inotify >= 0 && directory_of_watch.empty()) {
+        close(inotify);
+        inotify = -1;
+    }
+#endif
+    last_poll = std::chrono::steady_clock::now();
+}
+
+ShaderWatcher::~ShaderWatcher() {
+#ifdef __linux__
+    if (inotify >= 0)
+        close(inotify);
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// Methods
+// ----------------------------------------------------------------------------
+
+void ShaderWatcher::watch(ShaderProgram& program) {
+    targets.push_back({[&program] { return program.get_dependencies(); },
+                       [&program] { return program.get_dependencies_generation(); }, [&program] { program.reload(); }});
+    build_graph();
+}
+
+void ShaderWatcher::watch(ShaderPermutations& permutations) {
+    targets.push_back({[&permutations] { return permutations.get_dependencies(); },
+                       [&permutations] { return permutations.get_dependencies_generation(); },
+                       [&permutations] { permutations.reload(); }});
+    build_graph();
+}
+
+size_t ShaderWatcher::update() {
+    // The dependencies change only by the reloads or new variants, which are rare compared to the frames
+    const bool dependencies_changed = std::any_of(targets.begin(), targets.end(), [](const Target& target) {
+        return target.get_dependencies_generation() != target.generation;
+    });
+    if (dependencies_changed)
+        build_graph();
+
+    std::set<std::filesystem::path> changed;
+    if (inotify >= 0) {
+        read_events(changed);
+    } else {
+        poll_write_times(changed);
+    }
+
+    // A program depending on several changed files is reloaded only once
+    std::set<size_t> affected;
+    for (const std::filesystem::path& file : changed) {
+        const auto found = targets_of_file.find(file);
+        if (found != targets_of_file.end())
+            affected.insert(found->second.begin(), found->second.end());
+    }
+
+    for (size_t target : affected)
+        targets[target].reload();
+
+    return affected.size();
+}
+
+void ShaderWatcher::build_graph() {
+    targets_of_file.clear();
+    for (size_t i = 0; i < targets.size(); i++) {
+        targets[i].generation = targets[i].get_dependencies_generation();
+        for (const std::filesystem::path& dependency : targets[i].get_dependencies()) {
+            std::vector<size_t>& dependents = targets_of_file[normalize(dependency)];
+            if (std::find(dependents.begin(), dependents.end(), i) == dependents.end())
+                dependents.push_back(i);
+        }
+    }
+
+    if (inotify >= 0)
+        return;
+
+    // The new dependencies start with their current modification times, the removed ones are forgotten
+    std::error_code error;
+    for (auto it = write_times.begin(); it != write_times.end();)
+        it = targets_of_file.count(it->first) ? std::next(it) : write_times.erase(it);
+    for (const auto& [file, dependents] : targets_of_file) {
+        if (!write_times.count(file))
+            write_times[file] = std::filesystem::last_write_time(file, error);
+    }
+}
+
+std::filesystem::path ShaderWatcher::normalize(const std::filesystem::path& path) {
+    std::error_code error;
+    const std::filesystem::path absolute = std::filesystem::absolute(path, error);
+    return (error ? path : absolute).lexically_normal();
+}
+
+void ShaderWatcher::add_watches(const std::filesystem::path& root) {
+#ifdef __linux__
+    std::error_code error;
+    std::vector<std::filesystem::path> directories = {root};
+    for (std::filesystem::recursive_directory_iterator it{root, error}, end; !error && it != end; it.increment(error)) {
+        if (it->is_directory(error))
+            directories.push_back(it->path().lexically_normal());
+    }
+
+    for (const std::filesystem::path& watched : directories) {
+        // The editors either rewrite the file or replace it by a renamed one, new directories are watched as well
+        const int watch =
+            inotify_add_watch(inotify, watched.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+        if (watch >= 0)
+            directory_of_watch[watch] = watched;
+        else
+            std::cerr << "Could not watch " << watched.generic_string() << std::endl;
+    }
+#else
+    (void)root;
+#endif
+}
+
+void ShaderWatcher::read_events(std::set<std::filesystem::path>& changed) {
+#ifdef __linux__
+    alignas(inotify_event) char buffer[4096];
+    for (ssize_t length; (length = read(inotify, buffer, sizeof(buffer))) > 0;) {
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += ssize_t(sizeof(inotify_event) + event->len);
+
+            if (event->mask & IN_IGNORED) {
+                directory_of_watch.erase(event->wd);
+                continue;
+            }
+
+            const auto found = directory_of_watch.find(event->wd);
+            if (found == directory_of_watch.end() || event->len == 0)
+                continue;
+
+            const std::filesystem::path path = found->second / event->name;
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                    add_watches(path);
+            } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                changed.insert(path);
+            }
+        }
+    }
+#else
+    (void)changed;
+#endif
+}
+
+void ShaderWatcher::poll_write_times(std::set<std::filesystem::path>& changed) {
+    const auto now = std::chrono::steady_clock::now();
+    if (now - last_poll < POLL_INTERVAL)
+        return;
+    last_poll = now;
+
+    std::error_code error;
+    for (auto& [file, write_time] : write_times) {
+        const std::filesystem::file_time_type current = std::filesystem::last_write_time(file, error);
+        if (!error && current != write_time) {
+            write_time = current;
+            changed.insert(file);
+        }
+    }
+}
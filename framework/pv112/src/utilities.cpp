@@ -5,11 +5,20 @@
 // All rights reserved.
 // ################################################################################
 
+#include "utilities.hpp"
+#include "shader_preprocessor.hpp"
+
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <regex>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <glad/glad.h>
+#include <GLFW/glfw3.h>
 
 std::string load_file(std::filesystem::path file_path) {
     file_path.make_preferred();
@@ -22,9 +31,76 @@ std::string load_file(std::filesystem::path file_path) {
     return {std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>()};
 }
 
-GLuint create_shader(std::filesystem::path file_path, GLenum shader_type) {
-    const std::string shader_string = load_file(file_path);
-    const char* shader_source = shader_string.data();
+std::string add_defines(const std::string& source, const std::vector<std::string>& defines) {
+    if (defines.empty())
+        return source;
+
+    // The #version must stay the first directive, the defines follow it
+    const size_t version = source.find("#version");
+    const size_t line_end = version == std::string::npos ? std::string::npos : source.find('\n', version);
+    const size_t insert_at = line_end == std::string::npos ? 0 : line_end + 1;
+    const long next_line = long(std::count(source.begin(), source.begin() + insert_at, '\n')) + 1;
+
+    std::string block;
+    for (const std::string& define : defines) {
+        const size_t equals = define.find('=');
+        if (equals == std::string::npos)
+            block += "#define " + define + "\n";
+        else
+            block += "#define " + define.substr(0, equals) + " " + define.substr(equals + 1) + "\n";
+    }
+    block += "#line " + std::to_string(next_line) + "\n";
+
+    return source.substr(0, insert_at) + block + source.substr(insert_at);
+}
+
+namespace {
+/** Reads the info log of a shader or a program. */
+std::string get_info_log(GLuint name, bool is_program) {
+    GLint length = 0;
+    is_program ? glGetProgramiv(name, GL_INFO_LOG_LENGTH, &length) : glGetShaderiv(name, GL_INFO_LOG_LENGTH, &length);
+    if (length <= 1)
+        return {};
+
+    std::string log(size_t(length), '\0');
+    is_program ? glGetProgramInfoLog(name, length, nullptr, log.data())
+               : glGetShaderInfoLog(name, length, nullptr, log.data());
+    log.resize(log.find_last_not_of(std::string("\n\0", 2)) + 1);
+    return log;
+}
+
+/**
+ * Prefixes the messages of a compilation log by the file and the line, the drivers report them as "0:12(5): error"
+ * (Mesa), "0(12) : error" (NVIDIA) or "ERROR: 0:12:" (AMD, Intel), where the first number is the source string.
+ * The messages are kept as reported if the files are not known.
+ */
+std::string format_shader_log(const std::string& log, const std::vector<std::filesystem::path>& source_files) {
+    static const std::regex location(R"(^(ERROR: |WARNING: )?(\d+)[:(](\d+)\)?(\(\d+\))?\s*:?\s*)");
+
+    std::istringstream lines{log};
+    std::string result;
+    for (std::string line; std::getline(lines, line);) {
+        std::smatch match;
+        if (!source_files.empty() && std::regex_search(line, match, location)) {
+            const size_t source_number = std::stoul(match[2].str());
+            const std::filesystem::path& file = source_files[source_number < source_files.size() ? source_number : 0];
+            line = file.generic_string() + ":" + match[3].str() + ": " + match[1].str() + match.suffix().str();
+        }
+        result += line + "\n";
+    }
+    return result;
+}
+} // namespace
+
+GLuint compile_shader(const std::string& source, GLenum shader_type,
+                      const std::vector<std::filesystem::path>& source_files) {
+    const GLuint shader = submit_shader(source, shader_type);
+    check_shader(shader, source_files);
+    return shader;
+}
+
+GLuint submit_shader(const std::string& source, GLenum shader_type) {
+    const char* shader_source = source.data();
 
     GLuint shader = glCreateShader(shader_type);
     glShaderSource(shader, 1, &shader_source, nullptr);
@@ -33,6 +109,61 @@ GLuint create_shader(std::filesystem::path file_path, GLenum shader_type) {
     return shader;
 }
 
+bool check_shader(GLuint shader, const std::vector<std::filesystem::path>& source_files) {
+    GLint status = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    const std::string log = get_info_log(shader, false);
+    if (!log.empty() || status != GL_TRUE) {
+        std::cerr << (status == GL_TRUE ? "Compiled " : "Could not compile ") << source_files.front().generic_string()
+                  << (log.empty() ? "\n" : ":\n" + format_shader_log(log, source_files)) << std::flush;
+    }
+
+    return status == GL_TRUE;
+}
+
+GLuint create_shader(std::filesystem::path file_path, GLenum shader_type, const std::vector<std::string>& defines) {
+    const ShaderPreprocessor::Result& preprocessed = ShaderPreprocessor::preprocess(file_path);
+    return compile_shader(add_defines(preprocessed.source, defines), shader_type, preprocessed.files);
+}
+
+bool check_program(GLuint program, const std::string& name, const std::vector<std::filesystem::path>& source_files) {
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    const std::string log = get_info_log(program, true);
+    if (!log.empty() || status != GL_TRUE) {
+        std::cerr << (status == GL_TRUE ? "Linked " : "Could not link ") << name
+                  << (log.empty() ? "\n" : ":\n" + format_shader_log(log, source_files)) << std::flush;
+    }
+
+    return status == GL_TRUE;
+}
+
+bool enable_parallel_shader_compile() {
+    static const bool supported = [] {
+        bool khr = false;
+        bool arb = false;
+        GLint extension_count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+        for (GLint i = 0; i < extension_count; i++) {
+            const std::string_view extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+            khr = khr || extension == "GL_KHR_parallel_shader_compile";
+            arb = arb || extension == "GL_ARB_parallel_shader_compile";
+        }
+        if (!khr && !arb)
+            return false;
+
+        // The loader is generated without the extension, the entry point is resolved here
+        using MaxShaderCompilerThreads = void(APIENTRY*)(GLuint count);
+        const auto max_shader_compiler_threads = reinterpret_cast<MaxShaderCompilerThreads>(
+            glfwGetProcAddress(khr ? "glMaxShaderCompilerThreadsKHR" : "glMaxShaderCompilerThreadsARB"));
+        if (max_shader_compiler_threads)
+            max_shader_compiler_threads(0xFFFFFFFFu); // as many threads as the driver likes
+        return true;
+    }();
+
+    return supported;
+}
+
 GLuint create_program(std::filesystem::path vertex_path, std::filesystem::path fragment_path) {
     GLuint vertex_shader = create_shader(vertex_path, GL_VERTEX_SHADER);
     GLuint fragment_shader = create_shader(fragment_path, GL_FRAGMENT_SHADER);
@@ -41,6 +172,7 @@ GLuint create_program(std::filesystem::path vertex_path, std::filesystem::path f
     glAttachShader(program, vertex_shader);
     glAttachShader(program, fragment_shader);
     glLinkProgram(program);
+    check_program(program, vertex_path.generic_string() + " + " + fragment_path.generic_string());
 
     glDeleteShader(vertex_shader);
     glDeleteShader(fragment_shader);